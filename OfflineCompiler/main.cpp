@@ -0,0 +1,81 @@
+#include "_pch.h"
+
+using namespace core;
+using std::string;
+using std::wstring;
+using std::vector;
+using std::shared_ptr;
+
+#include "../OpenCL/_exports.h"
+using namespace opencl;
+
+/// Builds OpenCL programs for every device found and writes the binaries
+/// so that they can be loaded using Context::createProgramFromBinary
+/// on machines that do not have (or do not want to use) the runtime compiler.
+///
+/// Usage: OfflineCompiler <outputDir> <file.cl>... [-- <build options>...]
+///
+/// Writes <outputDir>/<file>.<device name>.bin for each file and device.
+int wmain(int argc, const wchar_t* argv[]) {
+	if(argc < 3) {
+		printf("Usage: OfflineCompiler <outputDir> <file.cl>... [-- <build options>...]\n");
+		return 1;
+	}
+	std::filesystem::path outputDir = argv[1];
+	vector<wstring> files;
+	vector<string> options;
+
+	bool isOption = false;
+	for(int i = 2; i<argc; i++) {
+		wstring arg = argv[i];
+		if(arg == L"--") {
+			isOption = true;
+		} else if(isOption) {
+			options.push_back(WString::toString(arg));
+		} else {
+			files.push_back(arg);
+		}
+	}
+
+	int failures = 0;
+	try{
+		std::filesystem::create_directories(outputDir);
+
+		OpenCL cl;
+		for(auto& platform : cl.createPlatforms()) {
+			for(auto& device : platform.getDevices()) {
+				if(!device.available || !device.compilerAvailable) continue;
+
+				/// Use the device name as part of the filename
+				string deviceName = device.name;
+				for(auto& ch : deviceName) {
+					if(!isalnum((ubyte)ch)) ch = '_';
+				}
+				auto context = platform.createContext(device);
+
+				for(auto& file : files) {
+					try{
+						auto program = context.createProgram(file, options);
+						auto binary  = program.getBinary();
+
+						auto outFile = outputDir / std::filesystem::path(file).stem();
+						outFile += "." + deviceName + ".bin";
+
+						std::ofstream out(outFile, std::ios::binary | std::ios::trunc);
+						out.write((const char*)binary.data(), binary.size());
+						if(!out) throw std::runtime_error("Unable to write " + outFile.string());
+
+						printf("Wrote %s (%llu bytes)\n", outFile.string().c_str(), (ulong)binary.size());
+					}catch(std::exception& e) {
+						printf("FAIL: %s\n", e.what());
+						failures++;
+					}
+				}
+			}
+		}
+	}catch(std::exception& e) {
+		printf("FAIL: %s\n", e.what());
+		return 1;
+	}
+	return failures == 0 ? 0 : 1;
+}
@@ -1,13 +1,30 @@
 #pragma once
 
 void throwOnCLError(int);
+void throwOnBuildError(int, cl_program, cl_device_id);
 
 #include "mem_object.h"
+#include "svm_buffer.h"
+#include "typed_buffer.h"
 #include "device.h"
 #include "kernel.h"
+#include "program_cache.h"
+#include "embedded_source.h"
+#include "program_source.h"
+#include "program_library.h"
 #include "event.h"
 #include "queue.h"
+#include "kernel_functor.h"
+#include "command_recording.h"
 #include "program.h"
+#include "program_variants.h"
+#include "program_manifest.h"
+#include "buffer_pool.h"
 #include "context.h"
+#include "build_option_tuner.h"
+#include "work_group_tuner.h"
+#include "occupancy.h"
+#include "tile_planner.h"
+#include "persistent_launch.h"
 #include "platform.h"
 #include "opencl.h"
@@ -10,7 +10,7 @@
 //#include <cstdio>
 //#include <cstdlib>
 #include <cassert>
-//#include <cstring>
+#include <cstring>
 
 /// std headers
 #include <memory>
@@ -19,6 +19,22 @@
 #include <exception>
 #include <algorithm>
 #include <tuple>
+#include <type_traits>
+#include <utility>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <future>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <unordered_map>
+#include <map>
+#include <list>
+#include <functional>
+#include <iterator>
+#include <cmath>
 
 /// OpenCL headers
 #include <CL/opencl.h>
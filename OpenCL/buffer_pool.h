@@ -0,0 +1,139 @@
+#pragma once
+
+namespace opencl {
+
+/// Reuses device buffers so that steady state code which creates and
+/// drops temporary buffers makes no driver allocations.
+///
+/// Requests are rounded up to a size class (powers of 2, with quarter
+/// steps above 64KB to limit waste on large buffers) and served from
+/// released buffers with the same class and flags. The returned Buffer
+/// reports the requested size. When the last shared_ptr is dropped the
+/// underlying cl_mem goes back to the pool, or is released if the pool
+/// is holding more than maxCachedBytes. Safe to use from multiple threads.
+///
+/// Usage:
+///		context.enableBufferPool();
+///		auto temp = context.createPooledBuffer(bytes, CL_MEM_READ_WRITE);
+class BufferPool final : public std::enable_shared_from_this<BufferPool> {
+	struct Key final {
+		cl_mem_flags flags;
+		ulong classSize;
+		bool operator<(const Key& o) const {
+			return flags < o.flags || (flags == o.flags && classSize < o.classSize);
+		}
+	};
+	cl_context context;
+	ulong maxCachedBytes;
+	mutable std::mutex lock;
+	std::map<Key, vector<cl_mem>> freeBuffers;
+
+	ulong requests = 0, hits = 0;
+	ulong bytesCached = 0;
+	ulong bytesInUse = 0;
+	ulong bytesRequestedInUse = 0;
+public:
+	BufferPool(cl_context context, ulong maxCachedBytes) : context(context), maxCachedBytes(maxCachedBytes) {}
+	~BufferPool() {
+		trim(0);
+	}
+	/// flags must not include CL_MEM_USE_HOST_PTR or CL_MEM_COPY_HOST_PTR
+	shared_ptr<Buffer> acquire(ulong numBytes, cl_mem_flags flags) {
+		assert((flags & (CL_MEM_USE_HOST_PTR | CL_MEM_COPY_HOST_PTR)) == 0);
+		Key key{flags, classSizeOf(numBytes)};
+		cl_mem id = nullptr;
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			requests++;
+			auto it = freeBuffers.find(key);
+			if(it != freeBuffers.end() && !it->second.empty()) {
+				id = it->second.back();
+				it->second.pop_back();
+				bytesCached -= key.classSize;
+				hits++;
+			}
+			bytesInUse += key.classSize;
+			bytesRequestedInUse += numBytes;
+		}
+		if(!id) {
+			int err;
+			id = clCreateBuffer(context, flags, key.classSize, nullptr, &err);
+			if(err) {
+				std::lock_guard<std::mutex> guard(lock);
+				bytesInUse -= key.classSize;
+				bytesRequestedInUse -= numBytes;
+			}
+			throwOnCLError(err);
+		}
+		std::weak_ptr<BufferPool> pool = shared_from_this();
+		return shared_ptr<Buffer>(new Buffer{id, flags, numBytes}, [pool, key](Buffer* buffer) {
+			if(auto p = pool.lock()) p->release(buffer, key);
+			delete buffer;
+		});
+	}
+	/// Release cached buffers until no more than maxBytes are cached
+	void trim(ulong maxBytes) {
+		std::lock_guard<std::mutex> guard(lock);
+		/// Largest first
+		for(auto it = freeBuffers.rbegin(); it != freeBuffers.rend() && bytesCached > maxBytes; ++it) {
+			auto& list = it->second;
+			while(!list.empty() && bytesCached > maxBytes) {
+				clReleaseMemObject(list.back());
+				list.pop_back();
+				bytesCached -= it->first.classSize;
+			}
+		}
+	}
+	void setMaxCachedBytes(ulong maxBytes) {
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			maxCachedBytes = maxBytes;
+		}
+		trim(maxBytes);
+	}
+	double getHitRate() const {
+		std::lock_guard<std::mutex> guard(lock);
+		return requests ? (double)hits / requests : 0;
+	}
+	/// Bytes held in released buffers waiting to be reused
+	ulong getBytesCached() const {
+		std::lock_guard<std::mutex> guard(lock);
+		return bytesCached;
+	}
+	/// Fraction of the in use bytes lost to size class rounding
+	double getFragmentation() const {
+		std::lock_guard<std::mutex> guard(lock);
+		return bytesInUse ? 1.0 - (double)bytesRequestedInUse / bytesInUse : 0;
+	}
+	string toString() const {
+		std::lock_guard<std::mutex> guard(lock);
+		return String::format("BufferPool {requests: %llu, hit rate: %.1f%%, in use: %llu KB, cached: %llu KB, fragmentation: %.1f%%}",
+							  requests, requests ? hits * 100.0 / requests : 0.0, bytesInUse / 1024, bytesCached / 1024,
+							  bytesInUse ? (1.0 - (double)bytesRequestedInUse / bytesInUse) * 100 : 0.0);
+	}
+	static ulong classSizeOf(ulong numBytes) {
+		ulong size = 256;
+		while(size < numBytes) size *= 2;
+		if(size <= 64 * 1024) return size;
+
+		/// Quarter steps between size/2 and size
+		ulong step = size / 8;
+		ulong classSize = size / 2;
+		while(classSize < numBytes) classSize += step;
+		return classSize;
+	}
+private:
+	void release(Buffer* buffer, const Key& key) {
+		std::lock_guard<std::mutex> guard(lock);
+		bytesInUse -= key.classSize;
+		bytesRequestedInUse -= buffer->size;
+		if(bytesCached + key.classSize > maxCachedBytes) return;
+
+		/// Keep a reference so the Buffer destructor does not free it
+		clRetainMemObject(buffer->id);
+		freeBuffers[key].push_back(buffer->id);
+		bytesCached += key.classSize;
+	}
+};
+
+} /// opencl
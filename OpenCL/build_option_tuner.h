@@ -0,0 +1,214 @@
+#pragma once
+
+namespace opencl {
+
+/// Finds the fastest set of build options for a kernel on the
+/// context device. Each candidate option set is built, run on
+/// representative inputs and timed using profiling events. Candidates
+/// whose output differs from the first (reference) candidate by more
+/// than the tolerance are rejected, and tuning fails if the reference
+/// candidate fails. Winners are persisted in a database file keyed by
+/// program, source hash, kernel, required options, device and driver.
+///
+/// Usage:
+///		BuildOptionTuner tuner{context, L"tuning.db"};
+///		auto options = tuner.tune(L"Kernels/add.cl", "Add", {}, benchmark);
+///		auto program = context.createProgram(L"Kernels/add.cl", options);
+class BuildOptionTuner {
+public:
+	struct Benchmark final {
+		/// Set the kernel arguments and enqueue the kernel on queue, signalling event
+		std::function<void(Kernel& kernel, CommandQueue& queue, Event& event)> run;
+		/// Read back the kernel output after a run
+		std::function<vector<float>(CommandQueue& queue)> readOutput;
+		/// Maximum relative error allowed compared to the reference output
+		float tolerance = 1e-4f;
+		uint iterations = 5;
+	};
+	struct Result final {
+		vector<string> options;
+		double millis = 0;
+		bool valid    = false;
+	};
+private:
+	Context& context;
+	std::filesystem::path databaseFile;
+	std::map<string, vector<string>> database;
+	vector<Result> lastResults;
+public:
+	BuildOptionTuner(Context& context, const wstring& databaseFile)
+		: context(context), databaseFile(databaseFile)
+	{
+		readDatabase();
+	}
+	/// The default candidates. The first one is the strict (reference) set.
+	static vector<vector<string>> defaultCandidates() {
+		auto standard = standardBuildOptions();
+
+		vector<string> uniform = standard;
+		uniform.push_back("-cl-uniform-work-group-size");
+
+		vector<string> noDenormsAreZero;
+		std::copy_if(standard.begin(), standard.end(), std::back_inserter(noDenormsAreZero),
+					 [](auto& opt) { return opt != "-cl-denorms-are-zero"; });
+
+		return {
+			{"-cl-std=CL2.0"},
+			{"-cl-std=CL2.0", "-cl-mad-enable"},
+			{"-cl-std=CL2.0", "-cl-fast-relaxed-math"},
+			noDenormsAreZero,
+			standard,
+			uniform
+		};
+	}
+	/// Returns previously tuned options for the kernel added to options,
+	/// or options unchanged (ie. the standard options) if it has not been tuned
+	/// with the same options.
+	vector<string> getOptions(const wstring& filename, const string& kernelName, vector<string> options = {}) const {
+		auto it = database.find(keyOf(filename, kernelName, options));
+		if(it != database.end()) {
+			options.push_back(NO_STANDARD_OPTIONS);
+			options.insert(options.end(), it->second.begin(), it->second.end());
+		}
+		return options;
+	}
+	/// Benchmark each candidate and store the fastest one that produces valid results.
+	/// Returns options (which should contain any required -D defines)
+	/// plus the winning candidate, suitable for Context::createProgram.
+	vector<string> tune(const wstring& filename,
+						const string& kernelName,
+						const vector<string>& options,
+						const Benchmark& benchmark,
+						vector<vector<string>> candidates = defaultCandidates())
+	{
+		assert(!candidates.empty());
+		auto queue = context.createQueue(true);
+
+		lastResults.clear();
+		vector<float> reference;
+
+		for(ulong i = 0; i<candidates.size(); i++) {
+			auto& candidate  = candidates[i];
+			bool isReference = i == 0;
+			Result result;
+			result.options = candidate;
+
+			vector<string> buildOptions = options;
+			buildOptions.push_back(NO_STANDARD_OPTIONS);
+			buildOptions.insert(buildOptions.end(), candidate.begin(), candidate.end());
+
+			try{
+				auto program = context.createProgram(filename, buildOptions);
+				auto kernel  = program.getKernel(kernelName);
+
+				/// Warm up and check the output
+				{
+					Event event;
+					benchmark.run(kernel, queue, event);
+					queue.finish();
+				}
+				auto output = benchmark.readOutput(queue);
+				if(isReference) reference = output;
+
+				bool matches = compare(reference, output, benchmark.tolerance);
+
+				ulong nanos = 0;
+				for(uint i = 0; i<benchmark.iterations; i++) {
+					Event event;
+					benchmark.run(kernel, queue, event);
+					queue.finish();
+					nanos += event.getRunTime();
+				}
+				result.millis = (nanos * 1e-6) / std::max(1u, benchmark.iterations);
+				/// Only once timing has succeeded
+				result.valid = matches;
+			}catch(std::exception& e) {
+				/// The other candidates cannot be checked without the reference output
+				if(isReference) throw std::runtime_error(String::format("Reference candidate failed: %s", e.what()));
+				/// Some drivers reject some options
+				printf("Candidate failed: %s\n", e.what());
+			}
+			lastResults.push_back(result);
+		}
+
+		const Result* best = nullptr;
+		for(auto& r : lastResults) {
+			if(r.valid && (!best || r.millis < best->millis)) best = &r;
+		}
+		if(!best) throw std::runtime_error("No valid build option candidates");
+
+		database[keyOf(filename, kernelName, options)] = best->options;
+		writeDatabase();
+
+		return getOptions(filename, kernelName, options);
+	}
+	/// Results of all candidates from the last call to tune
+	const vector<Result>& getLastResults() const {
+		return lastResults;
+	}
+	string toString() const {
+		CharBuffer buf{"BuildOptionTuner {\n"};
+		for(auto& r : lastResults) {
+			buf.appendFmt("  %s %8.3f ms :", r.valid ? "valid  " : "INVALID", r.millis);
+			for(auto& opt : r.options) {
+				buf.append(" ").append(opt);
+			}
+			buf.append("\n");
+		}
+		buf.append("}");
+		return buf.std_str();
+	}
+private:
+	/// options are the required options (eg. -D defines) passed to tune.
+	/// Includes the source hash so editing the kernel invalidates the entry
+	string keyOf(const wstring& filename, const string& kernelName, const vector<string>& options) const {
+		string src = File::readText(filename);
+		string key = WString::toString(filename) + "|" + 
+					 String::format("%016llx", hashFNV1a(src.data(), src.length())) + "|" + 
+					 kernelName + "|";
+		for(auto& opt : options) {
+			key += opt + " ";
+		}
+		return key + "|" + context.device.name + "|" + context.device.driverVersion;
+	}
+	static bool compare(const vector<float>& reference, const vector<float>& output, float tolerance) {
+		if(reference.size() != output.size()) return false;
+		for(ulong i = 0; i<output.size(); i++) {
+			float a = reference[i];
+			float b = output[i];
+			if(std::isnan(a) != std::isnan(b)) return false;
+			float scale = std::max(1.0f, std::max(std::abs(a), std::abs(b)));
+			if(std::abs(a - b) > tolerance * scale) return false;
+		}
+		return true;
+	}
+	/// One entry per line: key<TAB>option<TAB>option...
+	void readDatabase() {
+		std::ifstream in(databaseFile);
+		string line;
+		while(std::getline(in, line)) {
+			vector<string> parts;
+			ulong start = 0, tab;
+			while((tab = line.find('\t', start)) != string::npos) {
+				parts.push_back(line.substr(start, tab - start));
+				start = tab + 1;
+			}
+			parts.push_back(line.substr(start));
+			if(parts.size() < 2) continue;
+
+			database[parts[0]] = vector<string>(parts.begin() + 1, parts.end());
+		}
+	}
+	void writeDatabase() const {
+		std::ofstream out(databaseFile, std::ios::trunc);
+		for(auto& it : database) {
+			out << it.first;
+			for(auto& opt : it.second) {
+				out << "\t" << opt;
+			}
+			out << "\n";
+		}
+	}
+};
+
+} /// opencl
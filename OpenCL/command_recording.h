@@ -0,0 +1,219 @@
+#pragma once
+
+namespace opencl {
+
+/// A sequence of kernel launches, copies, fills and barriers which is
+/// recorded once and replayed on any CommandQueue, similar to a command
+/// buffer. Kernel arguments are captured when recorded and can be patched
+/// between replays. Replay does not allocate and only calls clSetKernelArg
+/// for arguments which differ from the kernel's current values.
+///
+/// Kernels and buffers are referenced, not owned, and must outlive the recording.
+///
+/// Replay needs an in-order queue. Only the first command waits on the
+/// wait list and only the last signals the event, which relies on the
+/// queue running the commands one after another.
+///
+/// Usage:
+///		CommandRecording rec;
+///		uint merge = rec.kernel(mergeKernel, NDRange{N}, NDRange{}, inBuf, outBuf, 256u);
+///		rec.copy(outBuf, inBuf);
+///		rec.replay(queue);
+///		rec.patchArg(merge, 2, 512u);
+///		rec.replay(queue);
+class CommandRecording {
+	enum class Type { KERNEL, COPY, FILL, BARRIER };
+
+	struct Arg final {
+		uint index;
+		uint size;
+		/// Offset into argBytes
+		uint offset;
+		bool isLocal;
+		/// A cl_mem, set with Kernel::setArgMem
+		bool isMem;
+	};
+	struct Command final {
+		Type type;
+		const Kernel* kernel = nullptr;
+		NDRange global, local, offset;
+		uint firstArg = 0, numArgs = 0;
+
+		const Buffer* src  = nullptr;
+		const Buffer* dest = nullptr;
+		ulong srcOffset = 0, destOffset = 0, numBytes = 0;
+		/// Fill pattern in argBytes
+		uint patternOffset = 0, patternSize = 0;
+	};
+	vector<Command> commands;
+	vector<Arg> args;
+	vector<ubyte> argBytes;
+	bool validated = false;
+public:
+	/// Record a kernel launch with all of its arguments.
+	/// Returns the command index for patchArg.
+	template<typename... Args>
+	uint kernel(const Kernel& kernel, const NDRange& global, const NDRange& local, const Args&... kernelArgs) {
+		return kernelWithOffset(kernel, global, local, NDRange{}, kernelArgs...);
+	}
+	template<typename... Args>
+	uint kernelWithOffset(const Kernel& kernel, const NDRange& global, const NDRange& local, const NDRange& offset, const Args&... kernelArgs) {
+		Command cmd;
+		cmd.type     = Type::KERNEL;
+		cmd.kernel   = &kernel;
+		cmd.global   = global;
+		cmd.local    = local;
+		cmd.offset   = offset;
+		cmd.firstArg = (uint)args.size();
+		cmd.numArgs  = sizeof...(Args);
+
+		uint index = 0;
+		(addArg(index++, KernelArg<Args>::size(kernelArgs), KernelArg<Args>::value(kernelArgs), std::is_base_of<MemObject, Args>::value), ...);
+		return add(cmd);
+	}
+	uint copy(const Buffer& src, const Buffer& dest) {
+		assert(src.size == dest.size);
+		return copy(src, 0, dest, 0, src.size);
+	}
+	uint copy(const Buffer& src, ulong srcOffset, const Buffer& dest, ulong destOffset, ulong numBytes) {
+		Command cmd;
+		cmd.type       = Type::COPY;
+		cmd.src        = &src;
+		cmd.dest       = &dest;
+		cmd.srcOffset  = srcOffset;
+		cmd.destOffset = destOffset;
+		cmd.numBytes   = numBytes;
+		return add(cmd);
+	}
+	/// Fill entire buffer with value
+	template<typename T>
+	uint fill(const Buffer& buffer, T value) {
+		Command cmd;
+		cmd.type          = Type::FILL;
+		cmd.dest          = &buffer;
+		cmd.numBytes      = buffer.size;
+		cmd.patternOffset = (uint)argBytes.size();
+		cmd.patternSize   = sizeof(T);
+		argBytes.insert(argBytes.end(), (const ubyte*)&value, (const ubyte*)&value + sizeof(T));
+		return add(cmd);
+	}
+	uint barrier() {
+		Command cmd;
+		cmd.type = Type::BARRIER;
+		return add(cmd);
+	}
+	/// Change a recorded kernel argument. The size must match the recorded argument.
+	template<typename T>
+	void patchArg(uint command, uint argIndex, const T& value) {
+		auto& cmd = commands.at(command);
+		assert(cmd.type == Type::KERNEL && argIndex < cmd.numArgs);
+
+		auto& arg = args[cmd.firstArg + argIndex];
+		ulong size = KernelArg<T>::size(value);
+		const void* ptr = KernelArg<T>::value(value);
+		if(size != arg.size || (ptr == nullptr) != arg.isLocal || std::is_base_of<MemObject, T>::value != arg.isMem) {
+			throw std::runtime_error(String::format("patchArg: argument %u of %s has a different size or kind", argIndex, cmd.kernel->name.c_str()));
+		}
+		if(ptr) memcpy(argBytes.data() + arg.offset, ptr, size);
+	}
+	/// Check each kernel has all of its arguments and each copy and fill
+	/// is within its buffers. Throws std::runtime_error on the first problem.
+	/// Called by the first replay.
+	void validate() {
+		for(uint i = 0; i<commands.size(); i++) {
+			auto& cmd = commands[i];
+			switch(cmd.type) {
+				case Type::KERNEL:
+					if(cmd.numArgs != cmd.kernel->getNumArgs()) {
+						fail(i, String::format("%s needs %u arguments but %u were recorded", cmd.kernel->name.c_str(), cmd.kernel->getNumArgs(), cmd.numArgs));
+					}
+					if(cmd.global.dims == 0 || (cmd.local.dims != 0 && cmd.local.dims != cmd.global.dims) ||
+					   (cmd.offset.dims != 0 && cmd.offset.dims != cmd.global.dims))
+					{
+						fail(i, "work sizes have different dimensions");
+					}
+					break;
+				case Type::COPY:
+					if(cmd.srcOffset + cmd.numBytes > cmd.src->size || cmd.destOffset + cmd.numBytes > cmd.dest->size) {
+						fail(i, "copy is out of bounds");
+					}
+					break;
+				case Type::FILL:
+					if(cmd.numBytes % cmd.patternSize != 0) fail(i, "buffer size is not a multiple of the fill pattern");
+					break;
+				case Type::BARRIER:
+					break;
+			}
+		}
+		validated = true;
+	}
+	/// Enqueue all commands on an in-order queue. The first waits on 
+	/// args.waitList and the last signals args.event.
+	void replay(CommandQueue& queue, CommandQueue::EventArgs eventArgs = {}) {
+		assert(isInOrder(queue));
+		if(!validated) validate();
+		if(commands.empty()) return;
+
+		for(uint i = 0; i<commands.size(); i++) {
+			auto& cmd = commands[i];
+			uint numWait           = i == 0 ? eventArgs.numWaitEvents() : 0;
+			const cl_event* wait   = numWait ? eventArgs.waitList.data() : nullptr;
+			cl_event* event        = (i == commands.size() - 1 && eventArgs.event) ? &eventArgs.event->id : nullptr;
+
+			switch(cmd.type) {
+				case Type::KERNEL:
+					for(uint a = cmd.firstArg; a < cmd.firstArg + cmd.numArgs; a++) {
+						auto& arg = args[a];
+						if(arg.isMem) {
+							cmd.kernel->setArgMem(arg.index, *(const cl_mem*)(argBytes.data() + arg.offset));
+						} else {
+							cmd.kernel->setArg(arg.index, arg.size, arg.isLocal ? nullptr : argBytes.data() + arg.offset);
+						}
+					}
+					throwOnCLError(clEnqueueNDRangeKernel(queue.id, cmd.kernel->id, cmd.global.dims,
+						cmd.offset.data(), cmd.global.data(), cmd.local.data(), numWait, wait, event));
+					break;
+				case Type::COPY:
+					throwOnCLError(clEnqueueCopyBuffer(queue.id, cmd.src->id, cmd.dest->id,
+						cmd.srcOffset, cmd.destOffset, cmd.numBytes, numWait, wait, event));
+					break;
+				case Type::FILL:
+					throwOnCLError(clEnqueueFillBuffer(queue.id, cmd.dest->id, argBytes.data() + cmd.patternOffset,
+						cmd.patternSize, 0, cmd.numBytes, numWait, wait, event));
+					break;
+				case Type::BARRIER:
+					throwOnCLError(clEnqueueBarrierWithWaitList(queue.id, numWait, wait, event));
+					break;
+			}
+		}
+	}
+	uint numCommands() const {
+		return (uint)commands.size();
+	}
+private:
+	uint add(const Command& cmd) {
+		commands.push_back(cmd);
+		validated = false;
+		return (uint)commands.size() - 1;
+	}
+	void addArg(uint index, ulong size, const void* value, bool isMem) {
+		Arg arg;
+		arg.index   = index;
+		arg.size    = (uint)size;
+		arg.offset  = (uint)argBytes.size();
+		arg.isLocal = value == nullptr;
+		arg.isMem   = isMem;
+		if(value) argBytes.insert(argBytes.end(), (const ubyte*)value, (const ubyte*)value + size);
+		args.push_back(arg);
+	}
+	static bool isInOrder(const CommandQueue& queue) {
+		cl_command_queue_properties properties = 0;
+		clGetCommandQueueInfo(queue.id, CL_QUEUE_PROPERTIES, sizeof(properties), &properties, nullptr);
+		return (properties & CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE) == 0;
+	}
+	static void fail(uint command, const string& msg) {
+		throw std::runtime_error(String::format("CommandRecording command %u: %s", command, msg.c_str()));
+	}
+};
+
+} /// opencl
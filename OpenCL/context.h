@@ -3,12 +3,31 @@
 namespace opencl {
 
 class Context {
+	shared_ptr<ProgramCache> programCache;
+	shared_ptr<BufferPool> bufferPool;
+	std::mutex libraryLock;
+	std::unordered_map<string, shared_ptr<ProgramLibrary>> libraries;
+	std::mutex programLock;
+	/// Shared programs built by prewarm or getProgram in the order they were requested
+	vector<std::pair<string, ProgramFuture>> programs;
+	std::mutex asyncLock;
+	/// Builds started by createProgramAsync which had not finished when last checked
+	vector<ProgramFuture> asyncBuilds;
 public:
 	Device& device;
 	cl_context context;
 
 	Context(cl_context context, Device& device) : context(context), device(device) {}
 	~Context() {  
+		/// Background builds use the context so finish them first
+		for(auto& it : programs) {
+			it.second.await();
+		}
+		for(auto& it : asyncBuilds) {
+			it.await();
+		}
+		programs.clear();
+		asyncBuilds.clear();
 		if(context) clReleaseContext(context);
 	}
 
@@ -44,6 +63,30 @@ public:
 		throwOnCLError(err);
 		return Buffer{bufferId, flags, numBytes};
 	}
+	/// Create a buffer of count elements of T. See createDeviceBuffer for the flags.
+	template<typename T>
+	TypedBuffer<T> createTypedBuffer(ulong count, cl_mem_flags flags, T* hostPtr = nullptr) {
+		int err;
+		cl_mem bufferId = clCreateBuffer(context, flags, count * sizeof(T), hostPtr, &err);
+		throwOnCLError(err);
+		return TypedBuffer<T>{bufferId, flags, count};
+	}
+	/// Allocate shared virtual memory. flags are the access flags plus
+	/// CL_MEM_SVM_FINE_GRAIN_BUFFER and/or CL_MEM_SVM_ATOMICS for fine grain.
+	/// alignment 0 uses the largest OpenCL C type alignment.
+	/// Throws if the device does not support the requested kind of SVM.
+	SvmBuffer createSvmBuffer(size_t numBytes, cl_svm_mem_flags flags = CL_MEM_READ_WRITE, uint alignment = 0) {
+		checkSvmSupport(flags);
+		void* ptr = clSVMAlloc(context, flags, numBytes, alignment);
+		if(!ptr) throw std::runtime_error(String::format("clSVMAlloc of %llu bytes failed", (ulong)numBytes));
+		return SvmBuffer{context, ptr, numBytes, flags};
+	}
+	/// An allocator for containers of SVM, eg. SvmVector<float> v(context.createSvmAllocator<float>())
+	template<typename T>
+	SvmAllocator<T> createSvmAllocator(cl_svm_mem_flags flags = CL_MEM_READ_WRITE | CL_MEM_SVM_FINE_GRAIN_BUFFER) {
+		checkSvmSupport(flags);
+		return SvmAllocator<T>{context, flags};
+	}
 	Image createDeviceImage(cl_mem_flags flags,
 							cl_image_format format,
 							cl_image_desc desc,
@@ -61,6 +104,34 @@ public:
 		throwOnCLError(err);
 		return Image{id, flags, desc.image_width, desc.image_height};
 	}
+	/// Create a 2D image with pixels of type T. Throws if sizeof(T)
+	/// is not the element size of format.
+	template<typename T>
+	TypedImage<T> createTypedImage2D(cl_mem_flags flags,
+									 ulong width,
+									 ulong height,
+									 cl_image_format format = ImageFormat<T>::value(),
+									 T* hostPtr = nullptr)
+	{
+		cl_image_desc desc = {};
+		desc.image_type   = CL_MEM_OBJECT_IMAGE2D;
+		desc.image_width  = width;
+		desc.image_height = height;
+
+		int err;
+		cl_mem id = clCreateImage(context, flags, &format, &desc, hostPtr, &err);
+		throwOnCLError(err);
+
+		size_t elementSize = 0;
+		err = clGetImageInfo(id, CL_IMAGE_ELEMENT_SIZE, sizeof(size_t), &elementSize, nullptr);
+		if(err || elementSize != sizeof(T)) {
+			clReleaseMemObject(id);
+			throwOnCLError(err);
+			throw std::runtime_error(String::format("Image element size is %llu bytes but the pixel type is %llu bytes",
+													(ulong)elementSize, (ulong)sizeof(T)));
+		}
+		return TypedImage<T>{id, flags, width, height, format};
+	}
 	/// flags:  CL_MEM_READ_ONLY, CL_MEM_WRITE_ONLY or CL_MEM_READ_WRITE
 	/// target: eg GL_TEXTURE_2D
 	Buffer createFromGLTexture(cl_mem_flags flags,
@@ -105,8 +176,161 @@ public:
 		throwOnCLError(err);
 		return CommandQueue{queueId};
 	}
-	Program createProgram(const wstring& filename, vector<string> options = {}) {
-		return Program{context, device, filename, options};
+	Program createProgram(const wstring& filename, 
+						  vector<string> options = {}, 
+						  vector<shared_ptr<ProgramLibrary>> libraries = {}) 
+	{
+		return Program{context, device, filename, options, libraries, programCache.get()};
+	}
+	/// Create from source held in memory, eg. generated at runtime
+	Program createProgramFromSource(const ProgramSource& source,
+									vector<string> options = {},
+									vector<shared_ptr<ProgramLibrary>> libraries = {})
+	{
+		return Program{context, device, source, options, libraries, programCache.get()};
+	}
+	/// Create from a source registered using registerEmbeddedSources
+	Program createProgramFromEmbedded(const string& name,
+									  vector<string> options = {},
+									  vector<shared_ptr<ProgramLibrary>> libraries = {})
+	{
+		auto source = findEmbeddedSource(name);
+		if(!source) throw std::runtime_error("Embedded source not found: " + name);
+		return Program{context, device, *source, options, libraries, programCache.get()};
+	}
+	/// Create from a SPIR-V file. Requires OpenCL 2.1 or cl_khr_il_program
+	Program createProgramFromIL(const wstring& filename, vector<string> options = {}) {
+		return Program{context, device, filename, Program::Format::IL, options};
+	}
+	/// Create from a binary built for this device (eg. by the OfflineCompiler tool).
+	/// This does not need the runtime compiler.
+	Program createProgramFromBinary(const wstring& filename, vector<string> options = {}) {
+		return Program{context, device, filename, Program::Format::BINARY, options};
+	}
+	/// Build the program on a worker thread. Programs created this way
+	/// are built concurrently and only block when the result is needed.
+	/// The Context waits for unfinished builds when it is destroyed.
+	ProgramFuture createProgramAsync(const wstring& filename, 
+									 vector<string> options = {}, 
+									 vector<shared_ptr<ProgramLibrary>> libraries = {}) 
+	{
+		cl_context ctxId = context;
+		Device* dev      = &device;
+		auto cache       = programCache;
+
+		auto future = std::async(std::launch::async, [=]() {
+			return std::make_shared<Program>(ctxId, *dev, filename, options, libraries, cache.get());
+		});
+		ProgramFuture result{future.share()};
+
+		std::lock_guard<std::mutex> guard(asyncLock);
+		asyncBuilds.erase(std::remove_if(asyncBuilds.begin(), asyncBuilds.end(),
+										 [](const ProgramFuture& f) { return f.isReady(); }),
+						  asyncBuilds.end());
+		asyncBuilds.push_back(result);
+		return result;
+	}
+	/// Programs built from filename specialised by -D defines passed to ProgramVariants::get.
+	/// Up to maxVariants specialisations (and maxBytes of binaries) are kept alive.
+	ProgramVariants createProgramVariants(const wstring& filename,
+										  vector<string> options = {},
+										  uint maxVariants = 16,
+										  ulong maxBytes = 64*1024*1024,
+										  vector<shared_ptr<ProgramLibrary>> libraries = {})
+	{
+		return ProgramVariants{context, device, filename, options, libraries, programCache.get(), maxVariants, maxBytes};
+	}
+	/// Returns a library of device functions compiled with options.
+	/// Each library is compiled once and shared by all programs that link it.
+	shared_ptr<ProgramLibrary> getLibrary(const wstring& filename, vector<string> options = {}) {
+		string key = WString::toString(filename);
+		for(auto& it : options) {
+			key += "|" + it;
+		}
+		std::lock_guard<std::mutex> guard(libraryLock);
+		auto& lib = libraries[key];
+		if(!lib) {
+			lib = std::make_shared<ProgramLibrary>(context, device, filename, options, programCache.get());
+		}
+		return lib;
+	}
+	/// Store built program binaries in directory and reuse them
+	/// on subsequent runs instead of building from source.
+	void enableProgramCache(const wstring& directory) {
+		programCache = std::make_shared<ProgramCache>(directory);
+	}
+	/// Returns nullptr if the cache is not enabled
+	ProgramCache* getProgramCache() const {
+		return programCache.get();
+	}
+	/// Reuse buffers returned by createPooledBuffer. Up to maxCachedBytes
+	/// of released buffers are kept for reuse.
+	void enableBufferPool(ulong maxCachedBytes = 256 * 1024 * 1024) {
+		bufferPool = std::make_shared<BufferPool>(context, maxCachedBytes);
+	}
+	/// Returns nullptr if the pool is not enabled
+	BufferPool* getBufferPool() const {
+		return bufferPool.get();
+	}
+	/// A buffer from the pool, or a new buffer if the pool is not enabled.
+	/// flags must not include CL_MEM_USE_HOST_PTR or CL_MEM_COPY_HOST_PTR.
+	shared_ptr<Buffer> createPooledBuffer(ulong numBytes, cl_mem_flags flags) {
+		if(bufferPool) return bufferPool->acquire(numBytes, flags);
+		return shared_ptr<Buffer>(new Buffer(createDeviceBuffer(numBytes, flags)));
+	}
+	/// Start building every manifest entry for this device type on worker threads.
+	/// Returns immediately. Use getProgram to fetch the results.
+	void prewarm(const ProgramManifest& manifest) {
+		for(auto& e : manifest.entries) {
+			if((e.deviceType & device.type) == 0) continue;
+			getProgramFuture(e.filename, e.options);
+		}
+	}
+	/// Returns the shared Program for filename and options, blocking until it is built.
+	/// Programs that were prewarmed are returned without building again.
+	shared_ptr<Program> getProgram(const wstring& filename, vector<string> options = {}) {
+		return getProgramFuture(filename, options).getShared();
+	}
+	/// Wait for all shared programs to finish building and return the build time of each
+	string awaitPrewarm() {
+		vector<std::pair<string, ProgramFuture>> copy;
+		{
+			std::lock_guard<std::mutex> guard(programLock);
+			copy = programs;
+		}
+		CharBuffer buf{"Prewarmed programs {\n"};
+		for(auto& it : copy) {
+			try{
+				auto& program = it.second.get();
+				buf.appendFmt("  %10.3f ms%s %s\n", program.buildMillis, program.loadedFromCache ? " (cached)" : "", it.first.c_str());
+			}catch(std::exception& e) {
+				buf.appendFmt("  FAILED %s: %s\n", it.first.c_str(), e.what());
+			}
+		}
+		buf.append("}");
+		return buf.std_str();
+	}
+private:
+	/// Throw if the device does not support the kind of SVM selected by flags
+	void checkSvmSupport(cl_svm_mem_flags flags) const {
+		cl_device_svm_capabilities required = CL_DEVICE_SVM_COARSE_GRAIN_BUFFER;
+		if(flags & CL_MEM_SVM_FINE_GRAIN_BUFFER) required = CL_DEVICE_SVM_FINE_GRAIN_BUFFER;
+		if(flags & CL_MEM_SVM_ATOMICS) required |= CL_DEVICE_SVM_ATOMICS;
+		if(!device.supportsSvm(required)) {
+			throw std::runtime_error(String::format("Device %s does not support the requested SVM (capabilities 0x%llx)", 
+				device.name.c_str(), (ulong)device.svmCapabilities));
+		}
+	}
+	ProgramFuture getProgramFuture(const wstring& filename, const vector<string>& options) {
+		string key = WString::toString(filename) + " " + createBuildOptions(options);
+
+		std::lock_guard<std::mutex> guard(programLock);
+		for(auto& it : programs) {
+			if(it.first == key) return it.second;
+		}
+		auto future = createProgramAsync(filename, options);
+		programs.emplace_back(key, future);
+		return future;
 	}
 };
 
@@ -7,6 +7,7 @@ public:
 	enum VendorID { UNKNOWN, NVIDIA, ATI, INTEL };
 
 	cl_device_id id;
+	cl_platform_id platformId;
 	VendorID vendorId = VendorID::UNKNOWN;
 	cl_device_type type;
 	uint maxComputeUnits;
@@ -27,6 +28,7 @@ public:
 	cl_command_queue_properties queueProperties;
 	cl_device_exec_capabilities execCaps;
 	cl_device_fp_config fpConfig;
+	cl_device_svm_capabilities svmCapabilities;
 	ulong timerResolution;
 	string name;
 	string deviceVersion;
@@ -41,6 +43,19 @@ public:
 		query(); 
 	}
 
+	bool hasExtension(const string& extension) const {
+		return (" " + extensions + " ").find(" " + extension + " ") != string::npos;
+	}
+	/// True if all of the CL_DEVICE_SVM_* capabilities are supported
+	bool supportsSvm(cl_device_svm_capabilities capabilities = CL_DEVICE_SVM_COARSE_GRAIN_BUFFER) const {
+		return (svmCapabilities & capabilities) == capabilities;
+	}
+	/// True if the device has cl_khr_subgroups. Sub-groups are also core in
+	/// OpenCL 2.1 but programs are built with -cl-std=CL2.0, which needs the extension
+	bool supportsSubGroups() const {
+		return hasExtension("cl_khr_subgroups");
+	}
+
 	string toString() const {
 		CharBuffer buf;
 
@@ -105,6 +120,13 @@ public:
 		if(fpConfig & CL_FP_FMA) buf.append("CL_FP_FMA ");
 		buf.append("\n");
 
+		buf.append("SVM capabilities    : ");
+		if(svmCapabilities & CL_DEVICE_SVM_COARSE_GRAIN_BUFFER) buf.append("COARSE_GRAIN_BUFFER ");
+		if(svmCapabilities & CL_DEVICE_SVM_FINE_GRAIN_BUFFER) buf.append("FINE_GRAIN_BUFFER ");
+		if(svmCapabilities & CL_DEVICE_SVM_FINE_GRAIN_SYSTEM) buf.append("FINE_GRAIN_SYSTEM ");
+		if(svmCapabilities & CL_DEVICE_SVM_ATOMICS) buf.append("ATOMICS");
+		buf.append("\n");
+
 		if(vendorId==NVIDIA) {
 		//	buf.append("nVidia compute capability : ").append(nvComputeCapabilityMajor).append(".").append(nvComputeCapabilityMinor).append("\n");
 		//	buf.append("nVidia regs per block     : ").append(nvRegsPerBlock).append("\n");
@@ -135,6 +157,7 @@ private:
 			printf("Unknown vendor '%s'\n", cb.c_str());
 		}
 
+		throwOnCLError(clGetDeviceInfo(id, CL_DEVICE_PLATFORM, sizeof(platformId), &platformId, nullptr));
 		throwOnCLError(clGetDeviceInfo(id, CL_DEVICE_TYPE, sizeof(type), &type, nullptr));
 		throwOnCLError(clGetDeviceInfo(id, CL_DEVICE_MAX_COMPUTE_UNITS, sizeof(maxComputeUnits), &maxComputeUnits, nullptr));
 		throwOnCLError(clGetDeviceInfo(id, CL_DEVICE_MAX_WORK_ITEM_DIMENSIONS, sizeof(maxWorkItemDims), &maxWorkItemDims, nullptr));
@@ -173,6 +196,11 @@ private:
 		throwOnCLError(clGetDeviceInfo(id, CL_DEVICE_MAX_CONSTANT_ARGS, sizeof(maxConstantArgs), &maxConstantArgs, nullptr));
 		throwOnCLError(clGetDeviceInfo(id, CL_DEVICE_SINGLE_FP_CONFIG, sizeof(fpConfig), &fpConfig, nullptr));
 
+		/// Not supported by 1.x devices
+		if(clGetDeviceInfo(id, CL_DEVICE_SVM_CAPABILITIES, sizeof(svmCapabilities), &svmCapabilities, nullptr) != CL_SUCCESS) {
+			svmCapabilities = 0;
+		}
+
 		if(vendorId==NVIDIA) {
 		//	clGetDeviceInfo(device, CL_NV_DEVICE_COMPUTE_CAPABILITY_MAJOR, sizeof(nvComputeCapabilityMajor), &nvComputeCapabilityMajor, nullptr);
 		//	clGetDeviceInfo(device, CL_NV_DEVICE_COMPUTE_CAPABILITY_MINOR, sizeof(nvComputeCapabilityMinor), &nvComputeCapabilityMinor, nullptr);
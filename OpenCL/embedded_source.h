@@ -0,0 +1,20 @@
+#pragma once
+
+namespace opencl {
+
+/// Program source compiled into the executable. Tables of these
+/// are generated at build time by Scripts/embed_kernels.ps1.
+struct EmbeddedSource final {
+	const char* name;		/// eg. "add.cl"
+	const char* source;
+	ulong length;
+	ulong hash;				/// hashFNV1a of source. Stable across builds
+};
+
+/// Make sources available to Context::createProgramFromEmbedded.
+/// Sources with the same name as a previously registered one replace it.
+void registerEmbeddedSources(const EmbeddedSource* sources, uint count);
+/// Returns nullptr if no source with this name has been registered
+const EmbeddedSource* findEmbeddedSource(const string& name);
+
+} /// opencl
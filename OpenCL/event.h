@@ -67,6 +67,17 @@ struct Event final {
 	}
 };
 
+/// Owns the single reference returned when a command signals event.
+/// Use for events the library creates internally: unlike ~Event, which
+/// releases every reference, this is safe while the command is still queued.
+struct ScopedEvent final {
+	Event event;
+
+	~ScopedEvent() {
+		if(event.id) clReleaseEvent(std::exchange(event.id, nullptr));
+	}
+};
+
 Event createUserEvent(shared_ptr<class Context> ctx);
 
 } /// opencl
\ No newline at end of file
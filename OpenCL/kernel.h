@@ -2,7 +2,46 @@
 
 namespace opencl {
 
+/// Pass as a kernel argument to reserve numBytes of local memory
+struct LocalMem final {
+	ulong numBytes;
+};
+
+/// Maps a C++ argument type to the size and value passed to clSetKernelArg.
+/// Scalars, OpenCL vector types (cl_float4 etc.) and plain structs are passed by value.
+template<typename T, typename Enable = void>
+struct KernelArg {
+	static_assert(!std::is_pointer<T>::value, "Host pointers are not valid kernel arguments");
+	static_assert(std::is_trivially_copyable<T>::value, "Kernel arguments must be trivially copyable");
+	static ulong size(const T&) { return sizeof(T); }
+	static const void* value(const T& v) { return &v; }
+};
+/// Buffers and images
+template<typename T>
+struct KernelArg<T, std::enable_if_t<std::is_base_of<MemObject, T>::value>> {
+	static ulong size(const T&) { return sizeof(cl_mem); }
+	static const void* value(const T& mem) { return &mem.id; }
+};
+template<>
+struct KernelArg<LocalMem> {
+	static ulong size(const LocalMem& local) { return local.numBytes; }
+	static const void* value(const LocalMem&) { return nullptr; }
+};
+
 class Kernel {
+	/// The last value set for each argument index
+	struct ArgShadow final {
+		bool isSet = false;
+		bool isLocal = false;
+		bool isSvm = false;
+		ulong size = 0;
+		vector<ubyte> bytes;
+		/// Memory object argument, retained while it is the argument
+		cl_mem mem = nullptr;
+	};
+	mutable vector<ArgShadow> shadows;
+	mutable ulong numArgsSet = 0;
+	mutable ulong numArgsSkipped = 0;
 public:
 	class Program& program;
 	cl_kernel id;
@@ -11,12 +50,30 @@ public:
 	Kernel(Program& program, const string& name) : program(program), name(name) { 
 		createKernel(); 
 	}
+	/// Take ownership of an existing kernel
+	Kernel(Program& program, const string& name, cl_kernel id) : program(program), id(id), name(name) {}
+	/// Owns the kernel and retains its memory object arguments so copies are not allowed
+	Kernel(const Kernel&) = delete;
+	Kernel& operator=(const Kernel&) = delete;
+	/// Takes the kernel and its argument state. Not assignable since program is a reference
+	Kernel(Kernel&& other) noexcept 
+		: shadows(std::move(other.shadows)), 
+		  numArgsSet(other.numArgsSet), 
+		  numArgsSkipped(other.numArgsSkipped), 
+		  program(other.program), 
+		  id(std::exchange(other.id, nullptr)), 
+		  name(std::move(other.name)) 
+	{
+		other.shadows.clear();
+	}
+	Kernel& operator=(Kernel&&) = delete;
 	~Kernel() { 
-		clReleaseKernel(id); 
+		releaseShadowMems();
+		if(id) clReleaseKernel(id); 
 	}
 
 	void setArg(uint index, const MemObject& mem) {
-		setArg(index, sizeof(cl_mem), &mem.id);
+		setArgMem(index, mem.id);
 	}
 	void setArg(uint index, uint value) {
 		setArg(index, sizeof(uint), &value);
@@ -24,9 +81,114 @@ public:
 	void setArg(uint index, float value) {
 		setArg(index, sizeof(float), &value);
 	}
+	/// Set any argument type supported by KernelArg
+	template<typename T>
+	void setArg(uint index, const T& value) {
+		if constexpr(std::is_base_of<MemObject, T>::value) {
+			setArgMem(index, value.id);
+		} else {
+			setArg(index, KernelArg<T>::size(value), KernelArg<T>::value(value));
+		}
+	}
+	/// Set arguments 0 to N-1, eg. setArgs(inBuf, outBuf, 10u, LocalMem{1024}, svmBuf)
+	template<typename... Args>
+	void setArgs(const Args&... args) {
+		uint index = 0;
+		(setArg(index++, args), ...);
+	}
+	/// Arguments whose value has not changed since they were last 
+	/// set are skipped and counted in getNumArgsSkipped.
+	/// value is nullptr for local memory arguments.
+	/// For plain values only. Memory objects must use setArgMem.
 	void setArg(uint index, ulong size, const void* value) const {
+		if(index >= shadows.size()) shadows.resize(index + 1);
+		auto& shadow = shadows[index];
+		bool isLocal = value == nullptr;
+
+		if(shadow.isSet && !shadow.isSvm && !shadow.mem && shadow.size == size && shadow.isLocal == isLocal && 
+		   (isLocal || memcmp(shadow.bytes.data(), value, size) == 0)) 
+		{
+			numArgsSkipped++;
+			return;
+		}
 		throwOnCLError(clSetKernelArg(id, index, size, value));
+		numArgsSet++;
+
+		releaseMem(shadow);
+		shadow.isSet   = true;
+		shadow.isLocal = isLocal;
+		shadow.isSvm   = false;
+		shadow.size    = size;
+		if(!isLocal) shadow.bytes.assign((const ubyte*)value, (const ubyte*)value + size);
+	}
+	/// Set a buffer or image argument. The memory object is retained until
+	/// the argument is changed or the kernel is released, so its handle
+	/// cannot be given to a new object while the shadow remembers it.
+	void setArgMem(uint index, cl_mem mem) const {
+		if(index >= shadows.size()) shadows.resize(index + 1);
+		auto& shadow = shadows[index];
+		if(shadow.isSet && shadow.mem == mem && mem) {
+			numArgsSkipped++;
+			return;
+		}
+		throwOnCLError(clSetKernelArg(id, index, sizeof(cl_mem), &mem));
+		numArgsSet++;
+
+		if(mem) clRetainMemObject(mem);
+		releaseMem(shadow);
+		shadow.isSet   = true;
+		shadow.isLocal = false;
+		shadow.isSvm   = false;
+		shadow.size    = sizeof(cl_mem);
+		shadow.mem     = mem;
+		shadow.bytes.clear();
+	}
+	void setArg(uint index, const SvmBuffer& svm) {
+		setArgSvm(index, svm.ptr);
 	}
+	/// Pass the storage of an SVM backed vector
+	template<typename T>
+	void setArg(uint index, const SvmVector<T>& vec) {
+		setArgSvm(index, vec.data());
+	}
+	/// Pass a pointer to (or into) an SVM allocation
+	void setArgSvm(uint index, const void* ptr) const {
+		if(index >= shadows.size()) shadows.resize(index + 1);
+		auto& shadow = shadows[index];
+		if(shadow.isSet && shadow.isSvm && shadow.size == sizeof(ptr) && memcmp(shadow.bytes.data(), &ptr, sizeof(ptr)) == 0) {
+			numArgsSkipped++;
+			return;
+		}
+		throwOnCLError(clSetKernelArgSVMPointer(id, index, ptr));
+		numArgsSet++;
+
+		releaseMem(shadow);
+		shadow.isSet   = true;
+		shadow.isLocal = false;
+		shadow.isSvm   = true;
+		shadow.size    = sizeof(ptr);
+		shadow.bytes.assign((const ubyte*)&ptr, (const ubyte*)&ptr + sizeof(ptr));
+	}
+	/// SVM allocations the kernel reaches through pointers stored in
+	/// other SVM data rather than through its arguments
+	void setSvmPointers(const vector<const void*>& pointers) const {
+		throwOnCLError(clSetKernelExecInfo(id, CL_KERNEL_EXEC_INFO_SVM_PTRS, pointers.size() * sizeof(void*), pointers.data()));
+	}
+	/// Forget the remembered argument values so that the next setArg
+	/// calls always reach the driver, and release the retained memory objects.
+	void invalidateArgs() const {
+		releaseShadowMems();
+		shadows.clear();
+	}
+	uint getNumArgs() const {
+		uint value;
+		throwOnCLError(clGetKernelInfo(id, CL_KERNEL_NUM_ARGS, sizeof(uint), &value, nullptr));
+		return value;
+	}
+	/// Number of clSetKernelArg calls made
+	ulong getNumArgsSet() const { return numArgsSet; }
+	/// Number of clSetKernelArg calls avoided because the value had not changed
+	ulong getNumArgsSkipped() const { return numArgsSkipped; }
 	ulong getMaxWorkGroupSize() const {
 		return getUlongWorkGroupInfo(CL_KERNEL_WORK_GROUP_SIZE);
 	}
@@ -39,6 +201,28 @@ public:
 	ulong getPreferredWorkGroupSizeMultiple() const {
 		return getUlongWorkGroupInfo(CL_KERNEL_PREFERRED_WORK_GROUP_SIZE_MULTIPLE);
 	}
+	/// The reqd_work_group_size attribute or {0,0,0} if not specified
+	vector<ulong> getCompileWorkGroupSize() const {
+		size_t sizes[3] = {};
+		getWorkGroupInfo(CL_KERNEL_COMPILE_WORK_GROUP_SIZE, sizes, sizeof(sizes));
+		return {sizes[0], sizes[1], sizes[2]};
+	}
+	/// Largest sub-group size for a work-group of localSizes, or 0 if the device does not support sub-groups
+	ulong getMaxSubGroupSize(const vector<ulong>& localSizes) const {
+		return getSubGroupInfo(CL_KERNEL_MAX_SUB_GROUP_SIZE_FOR_NDRANGE_KHR, localSizes);
+	}
+	/// Number of sub-groups in a work-group of localSizes, or 0 if the device does not support sub-groups
+	ulong getSubGroupCount(const vector<ulong>& localSizes) const {
+		return getSubGroupInfo(CL_KERNEL_SUB_GROUP_COUNT_FOR_NDRANGE_KHR, localSizes);
+	}
+	/// Local sizes should be a multiple of this. The sub-group size
+	/// if the driver reports one, otherwise the preferred multiple.
+	ulong getLocalSizeMultiple() const {
+		ulong subGroupSize = getMaxSubGroupSize({getMaxWorkGroupSize()});
+		return subGroupSize ? subGroupSize : std::max<ulong>(1, getPreferredWorkGroupSizeMultiple());
+	}
+	/// The most square 2D split of getLocalSizeMultiple.
+	/// Use TilePlanner for sizes that depend on the launch shape.
 	std::tuple<uint, uint> getSquareWorkGroupSize2D() const;
 private:
 	ulong getUlongWorkGroupInfo(cl_kernel_work_group_info param) const {
@@ -46,7 +230,17 @@ private:
 		getWorkGroupInfo(param, &value, sizeof(ulong));
 		return value;
 	}
+	static void releaseMem(ArgShadow& shadow) {
+		if(shadow.mem) clReleaseMemObject(shadow.mem);
+		shadow.mem = nullptr;
+	}
+	void releaseShadowMems() const {
+		for(auto& shadow : shadows) {
+			releaseMem(shadow);
+		}
+	}
 	void createKernel();
+	ulong getSubGroupInfo(cl_kernel_sub_group_info param, const vector<ulong>& localSizes) const;
 	void getWorkGroupInfo(cl_kernel_work_group_info param, void* paramPtr, ulong paramSize) const;
 };
 
@@ -0,0 +1,49 @@
+#pragma once
+
+namespace opencl {
+
+/// A kernel bound to a queue with typed arguments. Calling it sets the
+/// arguments (skipping any that have not changed) and enqueues the kernel
+/// in one call without allocating. No event is created unless one is
+/// passed in EventArgs.
+///
+/// The argument count is checked against the kernel when the functor is
+/// created and each argument type must be supported by KernelArg.
+///
+/// Usage:
+///		auto add = program.getKernelFunctor<Buffer, Buffer, Buffer, uint>("Add", queue);
+///		add(NDRange{N}, inA, inB, out, 50u);
+///
+///		Event event;
+///		add(NDRange{N}, NDRange{}, {{}, &event}, inA, inB, out, 50u);
+template<typename... Args>
+class KernelFunctor {
+	Kernel kernel;
+	CommandQueue& queue;
+public:
+	KernelFunctor(Program& program, const string& name, CommandQueue& queue)
+		: kernel(program, name), queue(queue)
+	{
+		if(kernel.getNumArgs() != sizeof...(Args)) {
+			throw std::runtime_error(String::format("Kernel %s has %u arguments but the functor has %u",
+													name.c_str(), kernel.getNumArgs(), (uint)sizeof...(Args)));
+		}
+	}
+	/// Enqueue with the driver (or tuner) choosing the local size
+	void operator()(const NDRange& global, const Args&... args) {
+		(*this)(global, NDRange{}, {}, args...);
+	}
+	void operator()(const NDRange& global, const NDRange& local, const Args&... args) {
+		(*this)(global, local, {}, args...);
+	}
+	/// Wait for eventArgs.waitList and signal eventArgs.event, if set
+	void operator()(const NDRange& global, const NDRange& local, CommandQueue::EventArgs eventArgs, const Args&... args) {
+		kernel.setArgs(args...);
+		queue.enqueueNDRange(kernel, global, local, std::move(eventArgs));
+	}
+	Kernel& getKernel() {
+		return kernel;
+	}
+};
+
+} /// opencl
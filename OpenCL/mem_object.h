@@ -9,17 +9,84 @@ public:
 	
 	MemObject(cl_mem id, cl_mem_flags flags) : id(id), flags(flags) {}
 	~MemObject() {
-		clReleaseMemObject(id);
+		if(id) clReleaseMemObject(id);
 	}
 };
 
-class Buffer final : public MemObject {
+class Buffer : public MemObject {
 public:
 	size_t size;
+	/// Set for sub-buffers. The parent is retained until the sub-buffer is released.
+	cl_mem parent = nullptr;
+	size_t offset = 0;
+
 	Buffer(cl_mem id, cl_mem_flags flags, size_t sizeBytes) : MemObject(id,flags), size(sizeBytes) {}
+	Buffer(cl_mem id, cl_mem_flags flags, size_t sizeBytes, cl_mem parent, size_t offset) 
+		: MemObject(id,flags), size(sizeBytes), parent(parent), offset(offset) 
+	{
+		clRetainMemObject(parent);
+	}
+	~Buffer() {
+		if(parent) {
+			/// Release the sub-buffer before its parent
+			clReleaseMemObject(id);
+			clReleaseMemObject(parent);
+			id = nullptr;
+		}
+	}
+	/// A view of size bytes at offset within this buffer which shares its memory.
+	/// offset must be a multiple of getSubBufferAlignment. flags = 0 inherits
+	/// the access flags of this buffer. Sub-buffers of sub-buffers are not allowed.
+	Buffer createSubBuffer(size_t offset, size_t size, cl_mem_flags flags = 0) const {
+		cl_mem_flags subFlags;
+		cl_mem subId = createRegion(offset, size, flags, subFlags);
+		return Buffer{subId, subFlags, size, id, offset};
+	}
+	/// Sub-buffer offsets must be a multiple of this many bytes 
+	/// (the largest CL_DEVICE_MEM_BASE_ADDR_ALIGN of the context devices)
+	size_t getSubBufferAlignment() const {
+		cl_context context;
+		throwOnCLError(clGetMemObjectInfo(id, CL_MEM_CONTEXT, sizeof(cl_context), &context, nullptr));
+
+		size_t numBytes = 0;
+		throwOnCLError(clGetContextInfo(context, CL_CONTEXT_DEVICES, 0, nullptr, &numBytes));
+		vector<cl_device_id> devices(numBytes / sizeof(cl_device_id));
+		throwOnCLError(clGetContextInfo(context, CL_CONTEXT_DEVICES, numBytes, devices.data(), nullptr));
+
+		cl_uint alignBits = 8;
+		for(auto device : devices) {
+			cl_uint bits;
+			throwOnCLError(clGetDeviceInfo(device, CL_DEVICE_MEM_BASE_ADDR_ALIGN, sizeof(cl_uint), &bits, nullptr));
+			alignBits = std::max(alignBits, bits);
+		}
+		return alignBits / 8;
+	}
+protected:
+	/// Validate and create the sub-buffer region. subFlags gets the effective flags.
+	cl_mem createRegion(size_t offset, size_t size, cl_mem_flags flags, cl_mem_flags& subFlags) const {
+		if(parent) throw std::runtime_error("Cannot create a sub-buffer of a sub-buffer");
+		if(offset + size > this->size || size == 0) {
+			throw std::runtime_error(String::format("Sub-buffer [%llu, %llu) is outside the buffer size %llu", 
+				(ulong)offset, (ulong)(offset + size), (ulong)this->size));
+		}
+		size_t alignment = getSubBufferAlignment();
+		if(offset % alignment != 0) {
+			throw std::runtime_error(String::format("Sub-buffer offset %llu is not a multiple of CL_DEVICE_MEM_BASE_ADDR_ALIGN (%llu bytes)", 
+				(ulong)offset, (ulong)alignment));
+		}
+
+		cl_buffer_region region = {offset, size};
+		int err;
+		cl_mem subId = clCreateSubBuffer(id, flags, CL_BUFFER_CREATE_TYPE_REGION, &region, &err);
+		throwOnCLError(err);
+
+		const cl_mem_flags ACCESS = CL_MEM_READ_WRITE | CL_MEM_READ_ONLY | CL_MEM_WRITE_ONLY;
+		subFlags = (flags & ACCESS) ? flags : (this->flags & ACCESS) | flags;
+		return subId;
+	}
 };
 
-class Image final : public MemObject {
+class Image : public MemObject {
 public:
 	ulong width, height;
 	Image(cl_mem id, cl_mem_flags flags, ulong width, ulong height)
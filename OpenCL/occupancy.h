@@ -0,0 +1,163 @@
+#pragma once
+
+namespace opencl {
+
+/// Estimates how many work-groups of a kernel can be resident on one
+/// compute unit at the same time and which resource limits it.
+///
+/// OpenCL does not report the per compute unit thread and register
+/// limits so these come from ComputeUnitLimits, which has rough
+/// per-vendor defaults and can be overridden with known values.
+/// Local memory use is the kernel's CL_KERNEL_LOCAL_MEM_SIZE, which
+/// includes local arrays and any local arguments already set.
+///
+/// Usage:
+///		auto occupancy = Occupancy::estimate(kernel, 256);
+///		printf("%s\n", Occupancy::report(program).c_str());
+struct Occupancy final {
+	enum class Limit { WORK_ITEMS, WORK_GROUPS, LOCAL_MEMORY, PRIVATE_MEMORY };
+
+	struct ComputeUnitLimits final {
+		ulong maxWorkItems;
+		ulong maxWorkGroups;
+		/// 0 if unknown
+		ulong privateMemBytes = 0;
+
+		static ComputeUnitLimits forDevice(const Device& device) {
+			if(device.type & CL_DEVICE_TYPE_CPU) return {device.maxWorkGroupSize, 1};
+			switch(device.vendorId) {
+				case Device::NVIDIA: return {2048, 32, 64 * 1024 * 4};	// 64K 32 bit registers
+				case Device::ATI:	 return {2560, 40, 256 * 1024};		// 4 SIMDs x 64KB VGPRs
+				case Device::INTEL:	 return {448, 16};
+				default:			 return {device.maxWorkGroupSize * 2, 16};
+			}
+		}
+	};
+
+	ulong localSize;
+	/// Local size rounded up to a multiple of the sub-group size
+	ulong effectiveLocalSize;
+	ulong localMemPerGroup;
+	ulong privateMemPerItem;
+	ulong workGroupsPerCU;
+	ulong workGroupsPerDevice;
+	/// Resident work-items as a fraction of ComputeUnitLimits::maxWorkItems
+	double occupancy;
+	Limit limit;
+
+	static Occupancy estimate(const Kernel& kernel, ulong localSize) {
+		return estimate(kernel, localSize, ComputeUnitLimits::forDevice(kernel.program.device));
+	}
+	static Occupancy estimate(const Kernel& kernel, ulong localSize, const ComputeUnitLimits& limits) {
+		assert(localSize > 0);
+		auto& device   = kernel.program.device;
+		ulong multiple = kernel.getLocalSizeMultiple();
+
+		Occupancy o;
+		o.localSize          = localSize;
+		o.effectiveLocalSize = ((localSize + multiple - 1) / multiple) * multiple;
+		o.localMemPerGroup   = kernel.getLocalMemSize();
+		o.privateMemPerItem  = kernel.getPrivateMemSize();
+
+		o.limit           = Limit::WORK_GROUPS;
+		o.workGroupsPerCU = limits.maxWorkGroups;
+
+		auto apply = [&](ulong groups, Limit limit) {
+			if(groups < o.workGroupsPerCU) {
+				o.workGroupsPerCU = groups;
+				o.limit = limit;
+			}
+		};
+		apply(limits.maxWorkItems / o.effectiveLocalSize, Limit::WORK_ITEMS);
+		if(o.localMemPerGroup > 0) {
+			apply(device.localMemSize / o.localMemPerGroup, Limit::LOCAL_MEMORY);
+		}
+		if(o.privateMemPerItem > 0 && limits.privateMemBytes > 0) {
+			apply(limits.privateMemBytes / (o.privateMemPerItem * o.effectiveLocalSize), Limit::PRIVATE_MEMORY);
+		}
+
+		o.workGroupsPerDevice = o.workGroupsPerCU * device.maxComputeUnits;
+		o.occupancy = (double)(o.workGroupsPerCU * o.effectiveLocalSize) / limits.maxWorkItems;
+		return o;
+	}
+	/// Local sizes (multiples of the sub-group size up to the kernel
+	/// maximum) which reach the highest estimated occupancy, smallest first.
+	/// Only the required size for kernels declaring reqd_work_group_size.
+	static vector<ulong> recommendLocalSizes(const Kernel& kernel) {
+		if(ulong required = requiredSize(kernel)) return {required};
+
+		auto limits    = ComputeUnitLimits::forDevice(kernel.program.device);
+		ulong multiple = kernel.getLocalSizeMultiple();
+		ulong maxSize  = kernel.getMaxWorkGroupSize();
+
+		vector<ulong> best;
+		double bestOccupancy = -1;
+		for(ulong size = std::min(multiple, maxSize); size <= maxSize; size += multiple) {
+			double occupancy = estimate(kernel, size, limits).occupancy;
+			if(occupancy > bestOccupancy + 1e-9) {
+				best.clear();
+				bestOccupancy = occupancy;
+			}
+			if(occupancy > bestOccupancy - 1e-9) best.push_back(size);
+		}
+		return best;
+	}
+	static const char* toString(Limit limit) {
+		switch(limit) {
+			case Limit::WORK_ITEMS:		return "work-items";
+			case Limit::WORK_GROUPS:	return "work-groups";
+			case Limit::LOCAL_MEMORY:	return "local memory";
+			case Limit::PRIVATE_MEMORY: return "private memory";
+		}
+		return "?";
+	}
+	string toString() const {
+		return String::format("local size %llu (%llu): %llu groups/CU, %llu groups/device, occupancy %.0f%%, limited by %s",
+							  localSize, effectiveLocalSize, workGroupsPerCU, workGroupsPerDevice, occupancy * 100, toString(limit));
+	}
+	/// Resource use, occupancy at the maximum (or required) work-group size and
+	/// recommended local sizes for every kernel in the program
+	static string report(Program& program) {
+		auto& device = program.device;
+		CharBuffer buf;
+		buf.appendFmt("Occupancy report: %s on %s (%u CUs, %llu KB local memory)\n",
+					  WString::toString(program.filename).c_str(), device.name.c_str(), device.maxComputeUnits, device.localMemSize / 1024);
+
+		for(auto& name : program.getKernelNames()) {
+			auto kernel     = program.getKernel(name);
+			ulong required  = requiredSize(kernel);
+			ulong groupSize = required ? required : kernel.getMaxWorkGroupSize();
+
+			buf.appendFmt("  %s\n", name.c_str());
+			buf.appendFmt("    max work-group size ... %llu\n", kernel.getMaxWorkGroupSize());
+			buf.appendFmt("    preferred multiple .... %llu\n", kernel.getPreferredWorkGroupSizeMultiple());
+			if(required) {
+				auto sizes = kernel.getCompileWorkGroupSize();
+				buf.appendFmt("    required size ......... %llu x %llu x %llu\n", sizes[0], sizes[1], sizes[2]);
+			}
+			buf.appendFmt("    sub-group size ........ %llu\n", kernel.getMaxSubGroupSize({groupSize}));
+			buf.appendFmt("    local memory .......... %llu bytes\n", kernel.getLocalMemSize());
+			buf.appendFmt("    private memory ........ %llu bytes\n", kernel.getPrivateMemSize());
+			buf.appendFmt("    %s %s\n", required ? "at required size ......" : "at max size ...........", estimate(kernel, groupSize).toString().c_str());
+
+			auto recommended = recommendLocalSizes(kernel);
+			buf.append("    recommended sizes ..... ");
+			for(auto size : recommended) {
+				buf.appendFmt("%llu ", size);
+			}
+			if(!recommended.empty()) {
+				buf.appendFmt("(%s)", estimate(kernel, recommended.front()).toString().c_str());
+			}
+			buf.append("\n");
+		}
+		return buf.std_str();
+	}
+private:
+	/// Total work-items of reqd_work_group_size, or 0 if the kernel does not declare one
+	static ulong requiredSize(const Kernel& kernel) {
+		auto sizes = kernel.getCompileWorkGroupSize();
+		return sizes[0] == 0 ? 0 : sizes[0] * std::max<ulong>(1, sizes[1]) * std::max<ulong>(1, sizes[2]);
+	}
+};
+
+} /// opencl
@@ -17,6 +17,13 @@ public:
 		}
 		throw std::runtime_error("Unable to find OpenCL platform");
 	}
+	vector<Platform> createPlatforms() const {
+		vector<Platform> platforms;
+		for(auto& pid : platformIds) {
+			platforms.push_back(Platform{pid});
+		}
+		return platforms;
+	}
 private:
 	void enumeratePlatforms() {
 		uint numPlatforms;
@@ -0,0 +1,67 @@
+#pragma once
+
+namespace opencl {
+
+/// Persistent-threads launch for irregular workloads. Only enough
+/// work-groups to fill the device are launched (see Occupancy) and
+/// each group repeatedly takes the next chunk of items from a global
+/// atomic counter until there are none left, so slow chunks do not
+/// hold up the scheduling of the rest.
+///
+/// The kernel takes three arguments from firstArgIndex onwards:
+///		global volatile uint* counter, const ulong numItems, const uint chunkSize
+/// and loops like this (see Samples/Kernels/persistent.cl):
+///		local uint chunk;
+///		while(true) {
+///			if(get_local_id(0) == 0) chunk = atomic_inc(counter);
+///			barrier(CLK_LOCAL_MEM_FENCE);
+///			ulong start = (ulong)chunk * chunkSize;
+///			barrier(CLK_LOCAL_MEM_FENCE);
+///			if(start >= numItems) return;
+///			for(ulong i = start + get_local_id(0); i < min(start + chunkSize, numItems); i += get_local_size(0)) ...
+///		}
+class PersistentLaunch {
+	Buffer counter;
+public:
+	PersistentLaunch(Context& context) 
+		: counter(context.createDeviceBuffer(sizeof(cl_uint), CL_MEM_READ_WRITE | CL_MEM_HOST_NO_ACCESS)) {}
+
+	/// Reset the counter and launch kernel over numItems. localSize and 
+	/// chunkSize default to the Occupancy recommendation and 8 work-groups 
+	/// worth of items. Returns the number of work-groups launched.
+	ulong enqueue(CommandQueue& queue,
+				  const Kernel& kernel,
+				  ulong numItems,
+				  uint firstArgIndex,
+				  ulong localSize = 0,
+				  uint chunkSize = 0,
+				  CommandQueue::EventArgs args = {})
+	{
+		if(localSize == 0) {
+			auto recommended = Occupancy::recommendLocalSizes(kernel);
+			localSize = recommended.empty() ? kernel.getMaxWorkGroupSize() : recommended.back();
+		}
+		if(chunkSize == 0) chunkSize = (uint)localSize * 8;
+
+		ulong numChunks = (numItems + chunkSize - 1) / chunkSize;
+		assert(numChunks <= 0xffffffffULL);
+
+		ulong numGroups = Occupancy::estimate(kernel, localSize).workGroupsPerDevice;
+		numGroups = std::max<ulong>(numGroups, kernel.program.device.maxComputeUnits);
+		numGroups = std::max<ulong>(1, std::min(numGroups, numChunks));
+
+		cl_ulong items = numItems;
+		cl_uint chunk  = chunkSize;
+		kernel.setArgMem(firstArgIndex, counter.id);
+		kernel.setArg(firstArgIndex + 1, sizeof(cl_ulong), &items);
+		kernel.setArg(firstArgIndex + 2, sizeof(cl_uint), &chunk);
+
+		/// The launch keeps its own reference to resetEvent while it waits
+		ScopedEvent resetEvent;
+		queue.enqueueFillBuffer<cl_uint>(counter, 0, {args.waitList, &resetEvent.event});
+		queue.enqueueNDRange(kernel, NDRange{numGroups * localSize}, NDRange{localSize}, {{resetEvent.event.id}, args.event});
+		return numGroups;
+	}
+};
+
+} /// opencl
@@ -17,11 +17,10 @@ public:
 		queryDevices(); 
 	}
 
+	vector<Device>& getDevices() {
+		return devices;
+	}
 	Context createContext(cl_device_type type, vector<cl_context_properties> props = {}) {
-		props.insert(props.begin(), (cl_context_properties)id);
-		props.insert(props.begin(), CL_CONTEXT_PLATFORM);
-		props.push_back(0);
-
 		/// Select the first matching device
 		int deviceIndex = -1;
 		for(int i = 0; i<devices.size(); i++) {
@@ -32,7 +31,15 @@ public:
 		}
 		if(deviceIndex == -1) throw std::runtime_error("Can't find OpenCL device on this platform");
 
-		cl_device_id deviceIds[] = {devices[deviceIndex].id};
+		return createContext(devices[deviceIndex], props);
+	}
+	/// Create a context for one of the devices returned by getDevices()
+	Context createContext(Device& device, vector<cl_context_properties> props = {}) {
+		props.insert(props.begin(), (cl_context_properties)id);
+		props.insert(props.begin(), CL_CONTEXT_PLATFORM);
+		props.push_back(0);
+
+		cl_device_id deviceIds[] = {device.id};
 		int err;
 		cl_context contextId = clCreateContext(
 			props.data(),
@@ -43,7 +50,7 @@ public:
 			&err
 		);
 		throwOnCLError(err);
-		return Context{contextId, devices[deviceIndex]};
+		return Context{contextId, device};
 	}
 	string toString() const {
 		CharBuffer buf{"Platform {\n"};
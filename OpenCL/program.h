@@ -4,64 +4,341 @@ namespace opencl {
 
 class Program {
 	cl_context contextId;
+	std::mutex kernelLock;
+	bool kernelsCreated = false;
+	/// Kernels created by clCreateKernelsInProgram not yet handed to a thread
+	std::unordered_map<string, std::unique_ptr<Kernel>> unclaimedKernels;
+	/// A kernel of each name which is never handed out, only cloned for
+	/// further threads, so no thread is setting its arguments meanwhile
+	std::unordered_map<string, cl_kernel> prototypes;
+	/// Unique for the process lifetime so a new Program at the same
+	/// address never finds an old Program's per-thread kernels
+	const ulong serial = nextSerial();
 public:
 	cl_program id;
 	wstring filename;
 	Device& device;
+	/// Hash of the source (or binary), build options and libraries.
+	/// Programs with the same buildHash are the same build.
+	ulong buildHash = 0;
+	/// Time taken to build or load the program
+	double buildMillis = 0;
+	bool loadedFromCache = false;
 
-	Program(cl_context ctxId, Device& device, const wstring& fileName, vector<string> options) 
+	/// If libraries are specified the source is compiled and then
+	/// linked with the libraries, otherwise it is built in one step.
+	Program(cl_context ctxId, 
+			Device& device, 
+			const wstring& fileName, 
+			vector<string> options, 
+			const vector<shared_ptr<ProgramLibrary>>& libraries = {}, 
+			ProgramCache* cache = nullptr) 
 		: contextId(ctxId), device(device), filename(fileName) 
 	{
-		load(options);
+		string src = File::readText(filename);
+		load({src.c_str()}, {src.length()}, hashFNV1a(src.data(), src.length()), options, libraries, cache);
+	}
+	/// Create from source strings held in memory.
+	/// filename is set to the source name.
+	Program(cl_context ctxId,
+			Device& device,
+			const ProgramSource& source,
+			vector<string> options,
+			const vector<shared_ptr<ProgramLibrary>>& libraries = {},
+			ProgramCache* cache = nullptr)
+		: contextId(ctxId), device(device), filename(source.name)
+	{
+		vector<const char*> strings;
+		vector<size_t> lengths;
+		for(auto& it : source.fragments) {
+			strings.push_back(it.c_str());
+			lengths.push_back(it.length());
+		}
+		load(strings, lengths, source.hash(), options, libraries, cache);
+	}
+	/// Create from source embedded in the executable. 
+	/// filename is set to the source name.
+	Program(cl_context ctxId,
+			Device& device,
+			const EmbeddedSource& source,
+			vector<string> options,
+			const vector<shared_ptr<ProgramLibrary>>& libraries = {},
+			ProgramCache* cache = nullptr)
+		: contextId(ctxId), device(device), filename(source.name, source.name + strlen(source.name))
+	{
+		load({source.source}, {source.length}, source.hash, options, libraries, cache);
+	}
+	enum class Format { IL, BINARY };
+	/// Create from a SPIR-V (IL) file or from a device binary 
+	/// previously written using getBinary.
+	Program(cl_context ctxId, Device& device, const wstring& fileName, Format format, vector<string> options)
+		: contextId(ctxId), device(device), filename(fileName)
+	{
+		loadBinary(format, options);
 	}
 	~Program() { 
+		threadKernels().erase(serial);
+		for(auto& it : prototypes) {
+			clReleaseKernel(it.second);
+		}
 		clReleaseProgram(id);
 	}
 
 	Kernel getKernel(const string& funcName) {
 		return Kernel{*this, funcName};
 	}
+	/// A new kernel bound to queue with typed arguments
+	template<typename... Args>
+	KernelFunctor<Args...> getKernelFunctor(const string& funcName, CommandQueue& queue) {
+		return {*this, funcName, queue};
+	}
+	/// Names of all kernels in the program
+	vector<string> getKernelNames() const {
+		size_t length = 0;
+		throwOnCLError(clGetProgramInfo(id, CL_PROGRAM_KERNEL_NAMES, 0, nullptr, &length));
+
+		string names(length, '\0');
+		throwOnCLError(clGetProgramInfo(id, CL_PROGRAM_KERNEL_NAMES, length, &names[0], nullptr));
+
+		vector<string> result;
+		std::istringstream in(names.c_str());
+		string name;
+		while(std::getline(in, name, ';')) {
+			if(!name.empty()) result.push_back(name);
+		}
+		return result;
+	}
+	/// The device binary of the built program
+	vector<ubyte> getBinary() const {
+		size_t length = 0;
+		throwOnCLError(clGetProgramInfo(id, CL_PROGRAM_BINARY_SIZES, sizeof(size_t), &length, nullptr));
+
+		vector<ubyte> binary(length);
+		ubyte* binaryPtr = binary.data();
+		throwOnCLError(clGetProgramInfo(id, CL_PROGRAM_BINARIES, sizeof(ubyte*), &binaryPtr, nullptr));
+		return binary;
+	}
+	/// Returns the calling thread's instance of the kernel.
+	/// All kernels are created together on first use and each thread
+	/// gets its own copy (since argument state is not thread safe).
+	/// The copies are held in thread_local storage and are released when
+	/// the thread exits, when the Program is destroyed (for the destroying
+	/// thread) or by releaseCachedKernels. Other threads should call
+	/// releaseCachedKernels before the Program is destroyed.
+	/// Repeated lookups do not lock or call the driver.
+	Kernel& getCachedKernel(const string& funcName) {
+		auto& kernels = threadKernels()[serial];
+		auto it = kernels.find(funcName);
+		if(it != kernels.end()) return *it->second;
+
+		std::lock_guard<std::mutex> guard(kernelLock);
+		if(!kernelsCreated) createAllKernels();
+
+		auto unclaimed = unclaimedKernels.find(funcName);
+		if(unclaimed != unclaimedKernels.end()) {
+			auto& kernel = kernels[funcName] = std::move(unclaimed->second);
+			unclaimedKernels.erase(unclaimed);
+			return *kernel;
+		}
+		return *(kernels[funcName] = cloneKernel(funcName));
+	}
+	/// Release the kernels cached for the calling thread
+	void releaseCachedKernels() {
+		threadKernels().erase(serial);
+	}
 private:
-	void load(vector<string> options) {
-		string src = File::readText(filename);
+	using KernelMap = std::unordered_map<string, std::unique_ptr<Kernel>>;
+
+	/// The calling thread's kernels, by Program serial
+	static std::unordered_map<ulong, KernelMap>& threadKernels() {
+		thread_local std::unordered_map<ulong, KernelMap> kernels;
+		return kernels;
+	}
+	static ulong nextSerial() {
+		static std::atomic<ulong> counter{0};
+		return ++counter;
+	}
+	void createAllKernels() {
+		uint numKernels;
+		throwOnCLError(clCreateKernelsInProgram(id, 0, nullptr, &numKernels));
+
+		vector<cl_kernel> ids(numKernels);
+		throwOnCLError(clCreateKernelsInProgram(id, numKernels, ids.data(), nullptr));
+
+		for(auto kernelId : ids) {
+			char name[256] = {};
+			throwOnCLError(clGetKernelInfo(kernelId, CL_KERNEL_FUNCTION_NAME, sizeof(name), name, nullptr));
+			unclaimedKernels[name] = std::make_unique<Kernel>(*this, name, kernelId);
+#ifdef CL_VERSION_2_1
+			int err;
+			cl_kernel prototypeId = clCreateKernel(id, name, &err);
+			throwOnCLError(err);
+			prototypes[name] = prototypeId;
+#endif
+		}
+		kernelsCreated = true;
+	}
+	/// Another thread already owns the original so make a new instance.
+	/// Cloning the unused prototype avoids parsing the program again but needs OpenCL 2.1
+	std::unique_ptr<Kernel> cloneKernel(const string& funcName) {
+#ifdef CL_VERSION_2_1
+		auto it = prototypes.find(funcName);
+		if(it != prototypes.end()) {
+			int err;
+			cl_kernel kernelId = clCloneKernel(it->second, &err);
+			throwOnCLError(err);
+			return std::make_unique<Kernel>(*this, funcName, kernelId);
+		}
+#endif
+		return std::make_unique<Kernel>(*this, funcName);
+	}
+	void load(const vector<const char*>& strings,
+			  const vector<size_t>& lengths,
+			  ulong sourceHash,
+			  const vector<string>& options,
+			  const vector<shared_ptr<ProgramLibrary>>& libraries,
+			  ProgramCache* cache)
+	{
+		string optionsStr = createBuildOptions(options);
+		auto start = std::chrono::high_resolution_clock::now();
+
+		string libraryKeys;
+		for(auto& lib : libraries) {
+			libraryKeys += "|" + lib->key;
+		}
+		string buildKey = optionsStr + libraryKeys;
+		buildHash = hashFNV1a(buildKey.data(), buildKey.length(), sourceHash);
+
+		string cacheKey;
+		if(cache) {
+			cacheKey = ProgramCache::createKey(sourceHash, buildKey, device);
+			/// Compile options are not valid when building a linked binary
+			this->id = cache->load(contextId, device, cacheKey, libraries.empty() ? optionsStr : "");
+			if(id) {
+				printf("Loaded program from cache: %s\n", WString::toString(filename).c_str());
+				loadedFromCache = true;
+				buildMillis = (std::chrono::high_resolution_clock::now() - start).count() * 1e-6;
+				return;
+			}
+		}
+		/// Don't count the cache lookup as build time
+		start = std::chrono::high_resolution_clock::now();
 
 		cl_int err;
-		const char* srcStr = src.c_str();
-		const size_t len = src.length();
-		this->id = clCreateProgramWithSource(contextId, 1, (const char**)&srcStr, &len, &err);
+		cl_program sourceId = clCreateProgramWithSource(contextId, (uint)strings.size(), (const char**)strings.data(), lengths.data(), &err);
 		throwOnCLError(err);
 		printf("Building program: %s\n", WString::toString(filename).c_str());
+		printf("Using options: %s\n", optionsStr.c_str());
 
-		/// Concatenate options
-		string optionsStr;
-		for(auto& it : options) {
-			optionsStr += it + " ";
+		if(libraries.empty()) {
+			this->id = sourceId;
+			err = clBuildProgram(id, 1, &device.id, optionsStr.c_str(), nullptr, nullptr);
+			checkBuild(err);
+		} else {
+			link(sourceId, optionsStr, libraries);
 		}
-		
-		string standardOptions = 
-			//"-Werror " 			            // Make all warnings into errors
-			//"-w"                              // inhibit all warnings
-			//"-cl-uniform-work-group-size "    // 2.0 only - requires that the global work-size be a multiple of the work-group size
-			//"-O5 "
-			"-cl-single-precision-constant " 	// Treat double precision floating-point constant as single precision constant
-			"-cl-fast-relaxed-math "			// Enable all unsafe maths optimisations
-			"-cl-mad-enable "
-			"-cl-no-signed-zeros "
-			"-cl-denorms-are-zero "
-			"-cl-std=CL2.0 ";
-		optionsStr += standardOptions;
-		printf("Using options: %s\n", optionsStr.c_str());
+		auto end = std::chrono::high_resolution_clock::now();
+		buildMillis = (end - start).count() * 1e-6;
+
+		if(cache) {
+			cache->store(id, cacheKey, buildMillis);
+		}
+	}
+	void loadBinary(Format format, const vector<string>& options) {
+		auto start = std::chrono::high_resolution_clock::now();
 
-		cl_device_id devices[] = {device.id};
-		err = clBuildProgram(id, 1, devices, optionsStr.c_str(), nullptr, nullptr);
-		if(err != CL_SUCCESS) {
-			ulong sizeGiven = 0;
-			char buildLog[10240] = {};
-			clGetProgramBuildInfo(id, device.id, CL_PROGRAM_BUILD_LOG, _countof(buildLog), buildLog, &sizeGiven);
+		std::ifstream in(std::filesystem::path(filename), std::ios::binary);
+		if(!in) throw std::runtime_error("Unable to read " + WString::toString(filename));
+		vector<ubyte> data{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
 
-			string msg{buildLog, sizeGiven};
-			throw std::runtime_error(("Compilation failed: " + msg).c_str());
+		string optionsStr = createBuildOptions(options);
+		buildHash = hashFNV1a(optionsStr.data(), optionsStr.length(), hashFNV1a((const char*)data.data(), data.size()));
+		int err;
+		if(format == Format::IL) {
+			this->id = createProgramWithIL(data);
+		} else {
+			const ubyte* dataPtr = data.data();
+			const size_t length  = data.size();
+			cl_int status;
+			this->id = clCreateProgramWithBinary(contextId, 1, &device.id, &length, &dataPtr, &status, &err);
+			throwOnCLError(err);
+			checkBuild(status);
 		}
+		printf("Building program: %s\n", WString::toString(filename).c_str());
+
+		err = clBuildProgram(id, 1, &device.id, optionsStr.c_str(), nullptr, nullptr);
+		checkBuild(err);
+
+		buildMillis = (std::chrono::high_resolution_clock::now() - start).count() * 1e-6;
+	}
+	cl_program createProgramWithIL(const vector<ubyte>& il) {
+		int err;
+#ifdef CL_VERSION_2_1
+		cl_program program = clCreateProgramWithIL(contextId, il.data(), il.size(), &err);
+#else
+		auto func = device.hasExtension("cl_khr_il_program") ? 
+			(clCreateProgramWithILKHR_fn)clGetExtensionFunctionAddressForPlatform(device.platformId, "clCreateProgramWithILKHR") : 
+			nullptr;
+		if(!func) throw std::runtime_error("Device does not support IL programs (cl_khr_il_program)");
+
+		cl_program program = func(contextId, il.data(), il.size(), &err);
+#endif
+		throwOnCLError(err);
+		return program;
+	}
+	void link(cl_program sourceId, const string& optionsStr, const vector<shared_ptr<ProgramLibrary>>& libraries) {
+		int err = clCompileProgram(sourceId, 1, &device.id, optionsStr.c_str(), 0, nullptr, nullptr, nullptr, nullptr);
+		try{
+			throwOnBuildError(err, sourceId, device.id);
+		}catch(...) {
+			clReleaseProgram(sourceId);
+			throw;
+		}
+
+		vector<cl_program> inputs = {sourceId};
+		for(auto& lib : libraries) {
+			printf("Linking library: %s\n", WString::toString(lib->filename).c_str());
+			inputs.push_back(lib->id);
+		}
+		this->id = clLinkProgram(contextId, 1, &device.id, nullptr, (uint)inputs.size(), inputs.data(), nullptr, nullptr, &err);
+		clReleaseProgram(sourceId);
+		checkBuild(err);
+	}
+	/// Throw if the build failed, releasing the program first since the
+	/// constructor is exiting and the destructor will not run
+	void checkBuild(int err) {
+		try{
+			throwOnBuildError(err, id, device.id);
+		}catch(...) {
+			if(id) clReleaseProgram(std::exchange(id, nullptr));
+			throw;
+		}
+	}
+};
+
+/// A Program that is being built on a worker thread.
+/// Copies share the same underlying Program.
+class ProgramFuture {
+	std::shared_future<shared_ptr<Program>> future;
+public:
+	ProgramFuture(std::shared_future<shared_ptr<Program>> future) : future(future) {}
+
+	bool isReady() const {
+		return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+	}
+	/// Block until the build has finished
+	void await() const {
+		future.wait();
+	}
+	/// Block until the build has finished. Rethrows any build error
+	Program& get() const {
+		return *future.get();
+	}
+	shared_ptr<Program> getShared() const {
+		return future.get();
+	}
+	Kernel getKernel(const string& funcName) const {
+		return get().getKernel(funcName);
 	}
 };
 
@@ -0,0 +1,151 @@
+#pragma once
+
+namespace opencl {
+
+/// 64 bit FNV-1a hash
+constexpr ulong hashFNV1a(const char* data, ulong length, ulong hash = 0xcbf29ce484222325ULL) {
+	for(ulong i = 0; i<length; i++) {
+		hash ^= (ubyte)data[i];
+		hash *= 0x100000001b3ULL;
+	}
+	return hash;
+}
+
+/// Opt-in on-disk cache of built program binaries.
+///
+/// Entries are keyed on the source hash, the full options string
+/// and the device name and driver version. Each entry stores the
+/// CL_PROGRAM_BINARIES of the built program and the time the source
+/// build took so that warm starts can report the time saved.
+/// Safe to use from multiple building threads.
+class ProgramCache {
+	static const uint MAGIC   = 0x43504c43;	// "CLPC"
+	static const uint VERSION = 1;
+
+	std::filesystem::path directory;
+	mutable std::mutex lock;
+	uint hits   = 0;
+	uint misses = 0;
+	double millisSaved = 0;
+public:
+	ProgramCache(const wstring& directory) : directory(directory) {
+		std::filesystem::create_directories(this->directory);
+	}
+
+	uint getHits() const {
+		std::lock_guard<std::mutex> guard(lock);
+		return hits;
+	}
+	uint getMisses() const {
+		std::lock_guard<std::mutex> guard(lock);
+		return misses;
+	}
+	/// Total source build time avoided by cache hits
+	double getBuildMillisSaved() const {
+		std::lock_guard<std::mutex> guard(lock);
+		return millisSaved;
+	}
+
+	static string createKey(ulong sourceHash, const string& options, const Device& device) {
+		return String::format("%016llx", sourceHash) +
+			"|" + options +
+			"|" + device.name +
+			"|" + device.driverVersion;
+	}
+	/// Create and build a program from a previously stored binary.
+	/// Compiled library objects are not built (build=false).
+	/// Returns nullptr if there is no entry or the entry is unusable.
+	cl_program load(cl_context contextId, const Device& device, const string& key, const string& options, bool build = true) {
+		auto start = std::chrono::high_resolution_clock::now();
+
+		double buildMillis;
+		vector<ubyte> binary;
+		if(!read(key, buildMillis, binary)) {
+			std::lock_guard<std::mutex> guard(lock);
+			misses++;
+			return nullptr;
+		}
+
+		const ubyte* binaryPtr = binary.data();
+		const size_t length    = binary.size();
+		cl_int status, err;
+		cl_program id = clCreateProgramWithBinary(contextId, 1, &device.id, &length, &binaryPtr, &status, &err);
+		if(build && err == CL_SUCCESS && status == CL_SUCCESS) {
+			err = clBuildProgram(id, 1, &device.id, options.c_str(), nullptr, nullptr);
+		}
+		if(err != CL_SUCCESS || status != CL_SUCCESS) {
+			/// Probably a driver update. Throw the entry away and rebuild from source
+			if(id) clReleaseProgram(id);
+			std::lock_guard<std::mutex> guard(lock);
+			std::error_code ec;
+			std::filesystem::remove(pathOf(key), ec);
+			misses++;
+			return nullptr;
+		}
+		auto end = std::chrono::high_resolution_clock::now();
+
+		std::lock_guard<std::mutex> guard(lock);
+		hits++;
+		millisSaved += std::max(0.0, buildMillis - (end - start).count() * 1e-6);
+		return id;
+	}
+	/// Store the binary of a successfully built program
+	void store(cl_program id, const string& key, double buildMillis) {
+		size_t length = 0;
+		throwOnCLError(clGetProgramInfo(id, CL_PROGRAM_BINARY_SIZES, sizeof(size_t), &length, nullptr));
+		if(length == 0) return;
+
+		vector<ubyte> binary(length);
+		ubyte* binaryPtr = binary.data();
+		throwOnCLError(clGetProgramInfo(id, CL_PROGRAM_BINARIES, sizeof(ubyte*), &binaryPtr, nullptr));
+
+		std::lock_guard<std::mutex> guard(lock);
+		std::ofstream out(pathOf(key), std::ios::binary | std::ios::trunc);
+		if(!out) return;
+
+		uint keyLength = (uint)key.length();
+		out.write((const char*)&MAGIC, sizeof(uint));
+		out.write((const char*)&VERSION, sizeof(uint));
+		out.write((const char*)&keyLength, sizeof(uint));
+		out.write(key.data(), keyLength);
+		out.write((const char*)&buildMillis, sizeof(double));
+		out.write((const char*)&length, sizeof(size_t));
+		out.write((const char*)binary.data(), length);
+	}
+	string toString() const {
+		std::lock_guard<std::mutex> guard(lock);
+		return String::format("ProgramCache {hits: %u, misses: %u, build time saved: %.3f ms}",
+							  hits, misses, millisSaved);
+	}
+private:
+	std::filesystem::path pathOf(const string& key) const {
+		return directory / String::format("%016llx.bin", hashFNV1a(key.data(), key.length()));
+	}
+	bool read(const string& key, double& buildMillis, vector<ubyte>& binary) const {
+		std::lock_guard<std::mutex> guard(lock);
+		std::ifstream in(pathOf(key), std::ios::binary);
+		if(!in) return false;
+
+		uint magic = 0, version = 0, keyLength = 0;
+		in.read((char*)&magic, sizeof(uint));
+		in.read((char*)&version, sizeof(uint));
+		in.read((char*)&keyLength, sizeof(uint));
+		if(!in || magic != MAGIC || version != VERSION || keyLength != key.length()) return false;
+
+		/// The file name is only a hash so check the full key matches
+		string storedKey(keyLength, '\0');
+		in.read(&storedKey[0], keyLength);
+		if(!in || storedKey != key) return false;
+
+		size_t length = 0;
+		in.read((char*)&buildMillis, sizeof(double));
+		in.read((char*)&length, sizeof(size_t));
+		if(!in || length == 0) return false;
+
+		binary.resize(length);
+		in.read((char*)binary.data(), length);
+		return (bool)in;
+	}
+};
+
+} /// opencl
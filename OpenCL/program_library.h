@@ -0,0 +1,79 @@
+#pragma once
+
+namespace opencl {
+
+/// Pass this as one of the options to build with exactly the options 
+/// given, without the standard options.
+const string NO_STANDARD_OPTIONS = "[no-standard-options]";
+
+/// The options appended to every build unless NO_STANDARD_OPTIONS is given
+vector<string> standardBuildOptions();
+/// Concatenate options and append the standard options
+string createBuildOptions(const vector<string>& options);
+/// Defines SUB_GROUPS if the device supports sub-groups so kernels can
+/// select sub-group collective versions (sub_group_reduce_add etc) with
+/// #ifdef SUB_GROUPS. Kernels using cl_khr_subgroups also need
+/// #pragma OPENCL EXTENSION cl_khr_subgroups : enable
+vector<string> subGroupBuildOptions(const Device& device);
+
+/// A compiled but unlinked program containing device functions
+/// that can be linked into any number of kernel programs.
+/// Create these via Context::getLibrary so that each library is
+/// only compiled once per device.
+class ProgramLibrary {
+public:
+	cl_program id;
+	wstring filename;
+	/// Identifies the compiled object. Part of the key of any
+	/// program linked against this library.
+	string key;
+
+	ProgramLibrary(cl_context ctxId, Device& device, const wstring& fileName, vector<string> options, ProgramCache* cache = nullptr)
+		: filename(fileName)
+	{
+		compile(ctxId, device, options, cache);
+	}
+	~ProgramLibrary() {
+		clReleaseProgram(id);
+	}
+private:
+	void compile(cl_context ctxId, Device& device, const vector<string>& options, ProgramCache* cache) {
+		string src        = File::readText(filename);
+		string optionsStr = createBuildOptions(options);
+		/// Prefixed so a library never shares a cache entry with a program built from the same source
+		this->key         = ProgramCache::createKey(hashFNV1a(src.data(), src.length()), "lib|" + optionsStr, device);
+
+		if(cache) {
+			this->id = cache->load(ctxId, device, key, optionsStr, false);
+			if(id) {
+				printf("Loaded library from cache: %s\n", WString::toString(filename).c_str());
+				return;
+			}
+		}
+		auto start = std::chrono::high_resolution_clock::now();
+
+		cl_int err;
+		const char* srcStr = src.c_str();
+		const size_t len = src.length();
+		this->id = clCreateProgramWithSource(ctxId, 1, (const char**)&srcStr, &len, &err);
+		throwOnCLError(err);
+		printf("Compiling library: %s\n", WString::toString(filename).c_str());
+
+		err = clCompileProgram(id, 1, &device.id, optionsStr.c_str(), 0, nullptr, nullptr, nullptr, nullptr);
+		try{
+			throwOnBuildError(err, id, device.id);
+		}catch(...) {
+			/// The constructor is exiting so the destructor will not release it
+			clReleaseProgram(id);
+			throw;
+		}
+
+		auto end = std::chrono::high_resolution_clock::now();
+
+		if(cache) {
+			cache->store(id, key, (end - start).count() * 1e-6);
+		}
+	}
+};
+
+} /// opencl
@@ -0,0 +1,56 @@
+#pragma once
+
+namespace opencl {
+
+/// The programs (and their options) a process is going to use.
+/// Pass to Context::prewarm to build them all in the background
+/// before the first request needs them.
+///
+/// File format, one program per line:
+///		<device type> <filename> [<option>...]
+///	where device type is one of ALL, CPU, GPU or ACCELERATOR. eg.
+///		# Comment
+///		GPU Kernels/sort.cl -D WORK_GROUP_SIZE=256 -D ASCENDING=true
+///		ALL Kernels/add.cl
+struct ProgramManifest final {
+	struct Entry final {
+		wstring filename;
+		vector<string> options;
+		cl_device_type deviceType = CL_DEVICE_TYPE_ALL;
+	};
+	vector<Entry> entries;
+
+	static ProgramManifest load(const wstring& filename) {
+		std::ifstream in{std::filesystem::path(filename)};
+		if(!in) throw std::runtime_error("Unable to read manifest " + WString::toString(filename));
+
+		ProgramManifest manifest;
+		string line;
+		while(std::getline(in, line)) {
+			vector<string> tokens;
+			string token;
+			std::istringstream stream(line);
+			while(stream >> token) {
+				tokens.push_back(token);
+			}
+			if(tokens.size() < 2 || tokens[0][0] == '#') continue;
+
+			Entry e;
+			e.deviceType = toDeviceType(tokens[0]);
+			e.filename   = wstring(tokens[1].begin(), tokens[1].end());
+			e.options    = vector<string>(tokens.begin() + 2, tokens.end());
+			manifest.entries.push_back(e);
+		}
+		return manifest;
+	}
+private:
+	static cl_device_type toDeviceType(const string& s) {
+		if(s == "CPU") return CL_DEVICE_TYPE_CPU;
+		if(s == "GPU") return CL_DEVICE_TYPE_GPU;
+		if(s == "ACCELERATOR") return CL_DEVICE_TYPE_ACCELERATOR;
+		if(s == "ALL") return CL_DEVICE_TYPE_ALL;
+		throw std::runtime_error("Unknown device type in manifest: " + s);
+	}
+};
+
+} /// opencl
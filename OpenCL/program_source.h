@@ -0,0 +1,40 @@
+#pragma once
+
+namespace opencl {
+
+/// Program source assembled in memory from one or more fragments,
+/// eg. kernels specialised and generated at runtime.
+/// Each fragment is passed to clCreateProgramWithSource as a separate string.
+///
+///	auto source = ProgramSource{L"generated"}
+///		.define("N", "16")
+///		.append(generateUnrolledLoop(16));
+///	auto program = context.createProgramFromSource(source);
+class ProgramSource {
+public:
+	/// Used in log messages and as the Program filename
+	wstring name;
+	vector<string> fragments;
+
+	ProgramSource(const wstring& name) : name(name) {}
+	ProgramSource(const wstring& name, vector<string> fragments) : name(name), fragments(fragments) {}
+
+	ProgramSource& append(const string& fragment) {
+		fragments.push_back(fragment);
+		return *this;
+	}
+	ProgramSource& define(const string& macro, const string& value) {
+		fragments.push_back("#define " + macro + " " + value + "\n");
+		return *this;
+	}
+	/// Hash of the concatenated fragments
+	ulong hash() const {
+		ulong h = hashFNV1a(nullptr, 0);
+		for(auto& it : fragments) {
+			h = hashFNV1a(it.data(), it.length(), h);
+		}
+		return h;
+	}
+};
+
+} /// opencl
@@ -0,0 +1,92 @@
+#pragma once
+
+namespace opencl {
+
+/// Built specialisations of one source file, one per distinct
+/// set of -D define values. Each combination is built once and kept
+/// until it becomes the least recently used variant and either more 
+/// than maxVariants are alive or their binaries exceed maxBytes.
+/// Evicted Programs stay valid while they are still referenced.
+class ProgramVariants {
+	struct Entry final {
+		string key;
+		shared_ptr<Program> program;
+		ulong numBytes;
+	};
+	cl_context contextId;
+	Device& device;
+	wstring filename;
+	vector<string> options;
+	vector<shared_ptr<ProgramLibrary>> libraries;
+	ProgramCache* cache;
+	uint maxVariants;
+	ulong maxBytes;
+
+	std::mutex lock;
+	std::list<Entry> entries;	/// most recently used first
+	std::unordered_map<string, std::list<Entry>::iterator> index;
+	ulong totalBytes = 0;
+	uint hits = 0, builds = 0, evictions = 0;
+public:
+	ProgramVariants(cl_context ctxId,
+					Device& device,
+					const wstring& filename,
+					vector<string> options,
+					vector<shared_ptr<ProgramLibrary>> libraries,
+					ProgramCache* cache,
+					uint maxVariants,
+					ulong maxBytes)
+		: contextId(ctxId), device(device), filename(filename), options(options), libraries(libraries),
+		  cache(cache), maxVariants(maxVariants), maxBytes(maxBytes) {}
+
+	/// Return the Program built with the given defines, building it if necessary
+	shared_ptr<Program> get(const std::map<string, string>& defines) {
+		string key;
+		for(auto& it : defines) {
+			key += it.first + "=" + it.second + " ";
+		}
+
+		std::lock_guard<std::mutex> guard(lock);
+		auto found = index.find(key);
+		if(found != index.end()) {
+			hits++;
+			entries.splice(entries.begin(), entries, found->second);
+			return found->second->program;
+		}
+
+		vector<string> variantOptions = options;
+		for(auto& it : defines) {
+			variantOptions.push_back("-D " + it.first + "=" + it.second);
+		}
+		auto program = std::make_shared<Program>(contextId, device, filename, variantOptions, libraries, cache);
+		builds++;
+
+		size_t numBytes = 0;
+		throwOnCLError(clGetProgramInfo(program->id, CL_PROGRAM_BINARY_SIZES, sizeof(size_t), &numBytes, nullptr));
+
+		entries.push_front(Entry{key, program, numBytes});
+		index[key] = entries.begin();
+		totalBytes += numBytes;
+
+		/// Evict least recently used but always keep the one just built
+		while(entries.size() > 1 && (entries.size() > maxVariants || totalBytes > maxBytes)) {
+			auto& last = entries.back();
+			totalBytes -= last.numBytes;
+			index.erase(last.key);
+			entries.pop_back();
+			evictions++;
+		}
+		return program;
+	}
+	uint numVariants() {
+		std::lock_guard<std::mutex> guard(lock);
+		return (uint)entries.size();
+	}
+	string toString() {
+		std::lock_guard<std::mutex> guard(lock);
+		return String::format("ProgramVariants {variants: %u, bytes: %llu, hits: %u, builds: %u, evictions: %u}",
+							  (uint)entries.size(), totalBytes, hits, builds, evictions);
+	}
+};
+
+} /// opencl
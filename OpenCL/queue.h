@@ -2,7 +2,40 @@
 
 namespace opencl {
 
+/// Work sizes for 1 to 3 dimensions. An empty NDRange as the local
+/// size lets the driver choose.
+struct NDRange final {
+	uint dims = 0;
+	ulong sizes[3] = {1, 1, 1};
+
+	NDRange() {}
+	NDRange(ulong x) : dims(1), sizes{x, 1, 1} {}
+	NDRange(ulong x, ulong y) : dims(2), sizes{x, y, 1} {}
+	NDRange(ulong x, ulong y, ulong z) : dims(3), sizes{x, y, z} {}
+
+	const ulong* data() const { return dims == 0 ? nullptr : sizes; }
+	/// global rounded up to a multiple of local in each dimension
+	static NDRange roundUp(const NDRange& global, const NDRange& local) {
+		NDRange result = global;
+		for(uint d = 0; d<local.dims; d++) {
+			result.sizes[d] = ((global[d] + local[d] - 1) / local[d]) * local[d];
+		}
+		return result;
+	}
+	ulong operator[](uint i) const { return sizes[i]; }
+};
+
+/// Limits for CommandQueue::enqueueChunked
+struct ChunkBudget final {
+	/// Maximum work-items in dimension 0 per launch
+	ulong maxItems = 1ULL << 24;
+	/// If > 0 the first chunk is timed and the remaining chunks are
+	/// sized to take about this long (but no more than maxItems)
+	double targetMillis = 0;
+};
+
 class CommandQueue {
+	class WorkGroupTuner* tuner = nullptr;
 public:
 	struct EventArgs final {
 		vector<cl_event> waitList;
@@ -16,6 +49,11 @@ public:
 	~CommandQueue() {
 		if(id) clReleaseCommandQueue(id);
 	}
+	/// Tuned mode. enqueueKernel calls which do not specify local sizes
+	/// use the sizes found by tuner, if any. Pass nullptr to turn it off.
+	void setWorkGroupTuner(class WorkGroupTuner* tuner) {
+		this->tuner = tuner;
+	}
 	/// Read entire buffer
 	void enqueueReadBuffer(const Buffer& buf, void* dest, cl_bool block, EventArgs args = {}) {
 		enqueueReadBuffer(buf, dest, 0, buf.size, block, args);
@@ -253,6 +291,69 @@ public:
 		throwOnCLError(err);
 		return ptr;
 	}
+	/// Make a coarse grain SVM region available to the host. Not needed for fine grain buffers.
+	void enqueueSvmMap(void* ptr,
+					   size_t numBytes,
+					   cl_map_flags flags,
+					   cl_bool block = CL_TRUE,
+					   EventArgs args = {})
+	{
+		throwOnCLError(clEnqueueSVMMap(
+			id,
+			block,
+			flags,
+			ptr,
+			numBytes,
+			args.numWaitEvents(),
+			args.waitList.data(),
+			args.event ? &args.event->id : nullptr
+		));
+	}
+	/// Map the whole buffer
+	void enqueueSvmMap(const SvmBuffer& svm, cl_map_flags flags, cl_bool block = CL_TRUE, EventArgs args = {}) {
+		enqueueSvmMap(svm.ptr, svm.size, flags, block, args);
+	}
+	/// Give a mapped SVM region back to the device
+	void enqueueSvmUnmap(void* ptr, EventArgs args = {}) {
+		throwOnCLError(clEnqueueSVMUnmap(
+			id,
+			ptr,
+			args.numWaitEvents(),
+			args.waitList.data(),
+			args.event ? &args.event->id : nullptr
+		));
+	}
+	void enqueueSvmUnmap(const SvmBuffer& svm, EventArgs args = {}) {
+		enqueueSvmUnmap(svm.ptr, args);
+	}
+	/// Copy between SVM and/or host memory
+	void enqueueSvmMemcpy(void* dest, const void* src, size_t numBytes, cl_bool block = CL_FALSE, EventArgs args = {}) {
+		throwOnCLError(clEnqueueSVMMemcpy(
+			id,
+			block,
+			dest,
+			src,
+			numBytes,
+			args.numWaitEvents(),
+			args.waitList.data(),
+			args.event ? &args.event->id : nullptr
+		));
+	}
+	/// Fill numBytes of SVM at ptr with value. numBytes must be a multiple of sizeof(T).
+	template<typename T>
+	void enqueueSvmMemFill(void* ptr, T value, size_t numBytes, EventArgs args = {}) {
+		assert(numBytes % sizeof(T) == 0);
+		throwOnCLError(clEnqueueSVMMemFill(
+			id,
+			ptr,
+			&value,
+			sizeof(T),				// pattern size
+			numBytes,
+			args.numWaitEvents(),
+			args.waitList.data(),
+			args.event ? &args.event->id : nullptr
+		));
+	}
 	/// Maps a region of image into the host address space
 	/// and returns a pointer to this mapped region. rowPitch and slicePitch are also set.
 	/// [[UNTESTED]]
@@ -295,35 +396,271 @@ public:
 			args.event ? &args.event->id : nullptr
 		));
 	}
+	/// Read entire typed buffer. dest must have buf.count() elements.
+	template<typename T>
+	void enqueueReadBuffer(const TypedBuffer<T>& buf, Span<typename TypedBuffer<T>::value_type> dest, cl_bool block, EventArgs args = {}) {
+		checkCount("enqueueReadBuffer", dest.size(), buf.count());
+		enqueueReadBuffer(buf, dest.data(), 0, buf.size, block, args);
+	}
+	/// Read dest.size() elements starting at element offset
+	template<typename T>
+	void enqueueReadBuffer(const TypedBuffer<T>& buf, Span<typename TypedBuffer<T>::value_type> dest, size_t offset, cl_bool block, EventArgs args = {}) {
+		checkRange("enqueueReadBuffer", offset, dest.size(), buf.count());
+		enqueueReadBuffer(buf, dest.data(), offset * sizeof(T), dest.sizeBytes(), block, args);
+	}
+	/// Write entire typed buffer. src must have dest.count() elements.
+	template<typename T>
+	void enqueueWriteBuffer(const TypedBuffer<T>& dest, Span<const typename TypedBuffer<T>::value_type> src, cl_bool block = CL_FALSE, EventArgs args = {}) {
+		checkCount("enqueueWriteBuffer", src.size(), dest.count());
+		enqueueWriteBuffer(dest, src.data(), 0, dest.size, block, args);
+	}
+	/// Write src.size() elements starting at element offset
+	template<typename T>
+	void enqueueWriteBuffer(const TypedBuffer<T>& dest, Span<const typename TypedBuffer<T>::value_type> src, size_t offset, cl_bool block, EventArgs args = {}) {
+		checkRange("enqueueWriteBuffer", offset, src.size(), dest.count());
+		enqueueWriteBuffer(dest, src.data(), offset * sizeof(T), src.sizeBytes(), block, args);
+	}
+	/// Copy whole typed buffer. Buffers of different element types do not compile.
+	template<typename T>
+	void enqueueCopyBuffer(const TypedBuffer<T>& src, const TypedBuffer<T>& dest, EventArgs args = {}) {
+		checkCount("enqueueCopyBuffer", dest.count(), src.count());
+		enqueueCopyBuffer(src, 0ULL, dest, 0ULL, src.size, args);
+	}
+	template<typename T, typename U>
+	void enqueueCopyBuffer(const TypedBuffer<T>& src, const TypedBuffer<U>& dest, EventArgs args = {}) = delete;
+	/// Map entire typed buffer
+	template<typename T>
+	Span<T> enqueueMapBuffer(const TypedBuffer<T>& buf, cl_map_flags flags, cl_bool block = CL_FALSE, EventArgs args = {}) {
+		return Span<T>{(T*)enqueueMapBuffer(buf, 0, buf.size, flags, block, args), buf.count()};
+	}
+	template<typename T>
+	void enqueueUnmapMemObject(const TypedBuffer<T>& buf, Span<T> mapped, EventArgs args = {}) {
+		enqueueUnmapMemObject(buf, (void*)mapped.data(), args);
+	}
+	/// Write entire typed image. src must have image.count() pixels.
+	template<typename T>
+	void enqueueWriteImage(const TypedImage<T>& image, Span<const typename TypedImage<T>::value_type> src, bool block = CL_FALSE, EventArgs args = {}) {
+		checkCount("enqueueWriteImage", src.size(), image.count());
+		enqueueWriteImage(image, src.data(), block, args);
+	}
+	/// Read entire typed image. dest must have image.count() pixels.
+	template<typename T>
+	void enqueueReadImage(const TypedImage<T>& image, Span<typename TypedImage<T>::value_type> dest, bool block = CL_FALSE, EventArgs args = {}) {
+		checkCount("enqueueReadImage", dest.size(), image.count());
+		enqueueReadImage(image, dest.data(), block, args);
+	}
+	/// globalOffsets are added to get_global_id and are empty (no offset) by default
 	void enqueueKernel(const Kernel& kernel,
 					   vector<ulong> globalSizes,
 					   vector<ulong> localSizes = {}, 
-					   EventArgs args = {}) 
+					   EventArgs args = {},
+					   vector<ulong> globalOffsets = {}) 
 	{
-		assert(globalSizes.size() <= 3);
+		assert(globalSizes.size() >= 1 && globalSizes.size() <= 3);
 		assert(localSizes.size() == 0 || localSizes.size() == globalSizes.size());
-		const ulong* local = localSizes.size() == 0 ? nullptr : localSizes.data();
+		enqueueNDRange(kernel, toNDRange(globalSizes), toNDRange(localSizes), args, toNDRange(globalOffsets));
+	}
+	/// Same as enqueueKernel but does not allocate, which matters for
+	/// tight dispatch loops. In tuned mode with no local size only the first
+	/// launch of each kernel and size bucket allocates.
+	void enqueueNDRange(const Kernel& kernel,
+						const NDRange& global,
+						const NDRange& local = NDRange{},
+						EventArgs args = {},
+						const NDRange& offset = NDRange{})
+	{
+		assert(global.dims >= 1 && global.dims <= 3);
+		assert(local.dims == 0 || local.dims == global.dims);
+		assert(offset.dims == 0 || offset.dims == global.dims);
 
+		NDRange tuned;
+		if(local.dims == 0 && tuner) {
+			tuned = getTunedLocalSize(kernel, global);
+		}
 		int err = 0;
 		err = clEnqueueNDRangeKernel(
 			id, 
 			kernel.id,
-			(uint)globalSizes.size(),	// dimensions
-			nullptr,					// always set this to null
-			globalSizes.data(),			// global work sizes
-			local,						// local work sizes
+			global.dims,				// dimensions
+			offset.data(),				// global work offsets
+			global.data(),				// global work sizes
+			local.dims ? local.data() : tuned.data(),	// local work sizes
 			args.numWaitEvents(),
 			args.waitList.data(),
 			args.event ? &args.event->id : nullptr
 		);
 		throwOnCLError(err);
 	}
+	/// Launch global rounded up to a multiple of local so any local size can be used.
+	/// The true global sizes are set as cl_ulong kernel arguments from sizeArgIndex
+	/// onwards, one per dimension. By convention the kernel starts with a bounds guard:
+	///		kernel void K(..., const ulong n) {
+	///			size_t i = get_global_id(0);
+	///			if(i >= n) return;
+	/// Kernels with barriers must keep padding work-items alive until after the
+	/// last barrier and only skip their loads and stores.
+	void enqueuePadded(const Kernel& kernel,
+					   const NDRange& global,
+					   const NDRange& local,
+					   uint sizeArgIndex,
+					   EventArgs args = {})
+	{
+		assert(local.dims == global.dims);
+		for(uint d = 0; d<global.dims; d++) {
+			cl_ulong size = global[d];
+			kernel.setArg(sizeArgIndex + d, sizeof(cl_ulong), &size);
+		}
+		enqueueNDRange(kernel, NDRange::roundUp(global, local), local, args);
+	}
+	/// Launch the largest multiple of local[0] with kernel and the remaining work-items
+	/// in dimension 0 with tailKernel using a global offset and a driver chosen local size.
+	/// tailKernel is usually the same kernel built without reqd_work_group_size and must
+	/// have the same arguments set. Waits on args.waitList and signals args.event when
+	/// both launches are complete.
+	void enqueueWithTail(const Kernel& kernel,
+						 const Kernel& tailKernel,
+						 const NDRange& global,
+						 const NDRange& local,
+						 EventArgs args = {})
+	{
+		assert(local.dims == global.dims);
+		for(uint d = 1; d<global.dims; d++) assert(global[d] % local[d] == 0);
+
+		NDRange bulk = global;
+		NDRange tail = global;
+		NDRange tailOffset;
+		bulk.sizes[0] = (global[0] / local[0]) * local[0];
+		tail.sizes[0] = global[0] - bulk[0];
+		tailOffset.dims = global.dims;
+		tailOffset.sizes[0] = bulk[0];
+		for(uint d = 1; d<global.dims; d++) tailOffset.sizes[d] = 0;
+
+		if(tail[0] == 0) {
+			enqueueNDRange(kernel, bulk, local, args);
+		} else if(bulk[0] == 0) {
+			enqueueNDRange(tailKernel, tail, NDRange{}, args, tailOffset);
+		} else {
+			/// Both launches can run at the same time on an out-of-order queue
+			if(!args.event) {
+				enqueueNDRange(kernel, bulk, local, {args.waitList});
+				enqueueNDRange(tailKernel, tail, NDRange{}, {args.waitList}, tailOffset);
+				return;
+			}
+			ScopedEvent bulkEvent, tailEvent;
+			enqueueNDRange(kernel, bulk, local, {args.waitList, &bulkEvent.event});
+			enqueueNDRange(tailKernel, tail, NDRange{}, {args.waitList, &tailEvent.event}, tailOffset);
+			enqueueBarrier({{bulkEvent.event.id, tailEvent.event.id}, args.event});
+		}
+	}
+	/// Called after each chunk is enqueued with its range in dimension 0
+	/// and its event, eg. to enqueue a read of that part of the output.
+	/// The event is released after the callback returns, so retain it
+	/// to keep it longer.
+	/// Reads only overlap later chunks on an out-of-order queue or a
+	/// second queue waiting on event.
+	using ChunkCallback = std::function<void(ulong offset, ulong count, const Event& event)>;
+
+	/// Split a large launch along dimension 0 into several launches using
+	/// global offsets so that each one stays within budget. The queue is
+	/// flushed after every chunk so the device can schedule other work in
+	/// between. Chunks are a multiple of local[0] if a local size is given.
+	/// If global[0] is smaller than local[0] the single chunk is rounded up
+	/// to local[0] so the kernel must skip work-items past the end, as with
+	/// enqueuePadded.
+	/// Returns the number of launches.
+	uint enqueueChunked(const Kernel& kernel,
+						const NDRange& global,
+						const NDRange& local = NDRange{},
+						ChunkBudget budget = {},
+						ChunkCallback onChunk = nullptr)
+	{
+		assert(global.dims >= 1 && global.dims <= 3);
+		ulong multiple  = local.dims ? local[0] : 1;
+		auto roundDown  = [&](ulong n) { return std::max(multiple, (n / multiple) * multiple); };
+		ulong chunkSize = roundDown(std::min(budget.maxItems, global[0]));
+
+		NDRange offset = global;
+		NDRange range  = global;
+		for(uint d = 0; d<global.dims; d++) offset.sizes[d] = 0;
+
+		uint launches = 0;
+		for(ulong start = 0; start < global[0]; start += range[0]) {
+			offset.sizes[0] = start;
+			range.sizes[0]  = global[0] < multiple ? multiple : std::min(chunkSize, global[0] - start);
+
+			/// Size the remaining chunks from the time the first one takes.
+			/// Wait for earlier work first so that it is not counted
+			bool timeChunk = launches == 0 && budget.targetMillis > 0;
+			if(timeChunk) finish();
+
+			auto begin = std::chrono::high_resolution_clock::now();
+			ScopedEvent chunk;
+			enqueueNDRange(kernel, range, local, {{}, onChunk ? &chunk.event : nullptr}, offset);
+			launches++;
+
+			if(timeChunk) {
+				finish();
+				double millis = (std::chrono::high_resolution_clock::now() - begin).count() * 1e-6;
+				double itemsPerMilli = range[0] / std::max(millis, 1e-3);
+				chunkSize = roundDown(std::min((double)budget.maxItems, itemsPerMilli * budget.targetMillis));
+			}
+			/// After timing so the commands it enqueues are not counted
+			if(onChunk) onChunk(start, std::min(range[0], global[0] - start), chunk.event);
+			flush();
+		}
+		return launches;
+	}
 	void flush() {
 		throwOnCLError(clFlush(id));
 	}
 	void finish() {
 		throwOnCLError(clFinish(id));
 	}
+private:
+	static void checkCount(const char* function, ulong count, ulong expected) {
+		if(count != expected) {
+			throw std::runtime_error(String::format("%s: %llu elements given but %llu expected", function, count, expected));
+		}
+	}
+	static void checkRange(const char* function, ulong offset, ulong count, ulong size) {
+		if(offset + count > size) {
+			throw std::runtime_error(String::format("%s: elements [%llu, %llu) are outside the buffer of %llu", function, offset, offset + count, size));
+		}
+	}
+	static NDRange toNDRange(const vector<ulong>& sizes) {
+		switch(sizes.size()) {
+			case 1: return {sizes[0]};
+			case 2: return {sizes[0], sizes[1]};
+			case 3: return {sizes[0], sizes[1], sizes[2]};
+		}
+		return {};
+	}
+	NDRange getTunedLocalSize(const Kernel& kernel, const NDRange& global) const;
+};
+
+/// Maps SVM for host access for the lifetime of the scope. Only needed
+/// for coarse grain SVM.
+class SvmMapScope final {
+	CommandQueue& queue;
+	void* ptr;
+public:
+	/// Nothing is mapped if numBytes is 0
+	SvmMapScope(CommandQueue& queue, void* ptr, size_t numBytes, cl_map_flags flags) 
+		: queue(queue), ptr(numBytes ? ptr : nullptr) 
+	{
+		if(this->ptr) queue.enqueueSvmMap(ptr, numBytes, flags, CL_TRUE);
+	}
+	/// Map the whole capacity of vec. Nothing is mapped if it has no capacity.
+	template<typename T>
+	SvmMapScope(CommandQueue& queue, SvmVector<T>& vec, cl_map_flags flags) 
+		: SvmMapScope(queue, vec.data(), vec.capacity() * sizeof(T), flags) {}
+	~SvmMapScope() {
+		if(!ptr) return;
+		/// Destructors must not throw
+		int err = clEnqueueSVMUnmap(queue.id, ptr, 0, nullptr, nullptr);
+		if(err) Log::write(String::format("SvmMapScope: clEnqueueSVMUnmap failed (%d)", err));
+		assert(err == CL_SUCCESS);
+	}
 };
 
 } /// opencl
\ No newline at end of file
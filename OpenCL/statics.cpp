@@ -46,14 +46,84 @@ void throwOnCLError(int err) {
 	}
 }
 
+void throwOnBuildError(int err, cl_program program, cl_device_id device) {
+	if(err) {
+		ulong sizeGiven = 0;
+		char buildLog[10240] = {};
+		if(program) {
+			clGetProgramBuildInfo(program, device, CL_PROGRAM_BUILD_LOG, _countof(buildLog), buildLog, &sizeGiven);
+		}
+		string msg{buildLog, sizeGiven};
+		throw std::runtime_error(("Compilation failed: " + msg).c_str());
+	}
+}
+
 namespace opencl {
 
+static vector<EmbeddedSource> embeddedSources;
+
+void registerEmbeddedSources(const EmbeddedSource* sources, uint count) {
+	for(uint i = 0; i<count; i++) {
+		auto it = std::find_if(embeddedSources.begin(), embeddedSources.end(), 
+							   [&](auto& s) { return strcmp(s.name, sources[i].name) == 0; });
+		if(it != embeddedSources.end()) {
+			*it = sources[i];
+		} else {
+			embeddedSources.push_back(sources[i]);
+		}
+	}
+}
+const EmbeddedSource* findEmbeddedSource(const string& name) {
+	for(auto& it : embeddedSources) {
+		if(name == it.name) return &it;
+	}
+	return nullptr;
+}
+vector<string> standardBuildOptions() {
+	return {
+		//"-Werror", 			            // Make all warnings into errors
+		//"-w",                             // inhibit all warnings
+		//"-cl-uniform-work-group-size",    // 2.0 only - requires that the global work-size be a multiple of the work-group size
+		//"-O5",
+		"-cl-single-precision-constant", 	// Treat double precision floating-point constant as single precision constant
+		"-cl-fast-relaxed-math",			// Enable all unsafe maths optimisations
+		"-cl-mad-enable",
+		"-cl-no-signed-zeros",
+		"-cl-denorms-are-zero",
+		"-cl-std=CL2.0"
+	};
+}
+vector<string> subGroupBuildOptions(const Device& device) {
+	if(!device.supportsSubGroups()) return {};
+	return {"-D SUB_GROUPS=1"};
+}
+string createBuildOptions(const vector<string>& options) {
+	string optionsStr;
+	bool standard = true;
+	for(auto& it : options) {
+		if(it == NO_STANDARD_OPTIONS) {
+			standard = false;
+			continue;
+		}
+		optionsStr += it + " ";
+	}
+	if(standard) {
+		for(auto& it : standardBuildOptions()) {
+			optionsStr += it + " ";
+		}
+	}
+	return optionsStr;
+}
+
 Event createUserEvent(shared_ptr<Context> ctx) {
 	int err;
 	cl_event evt = clCreateUserEvent(ctx->context, &err);
 	throwOnCLError(err);
 	return Event{evt};
 }
+NDRange CommandQueue::getTunedLocalSize(const Kernel& kernel, const NDRange& global) const {
+	return tuner->getLocalSize(kernel, global);
+}
 void Kernel::createKernel() {
 	int err;
 	this->id = clCreateKernel(program.id, name.c_str(), &err);
@@ -69,14 +139,32 @@ void Kernel::getWorkGroupInfo(cl_kernel_work_group_info param, void* paramPtr, u
 		nullptr
 	));
 }
-std::tuple<uint, uint> Kernel::getSquareWorkGroupSize2D() const {
-	uint n = (uint)getPreferredWorkGroupSizeMultiple();
+ulong Kernel::getSubGroupInfo(cl_kernel_sub_group_info param, const vector<ulong>& localSizes) const {
+	auto& device = program.device;
+	if(!device.supportsSubGroups()) return 0;
 
-	// AMD is always 64
-	if(n == 64) return {8, 8};
-
-	// NVidia and Intel seem to like 32
-	if(n == 32) return {8, 4};
+	size_t value = 0;
+#ifdef CL_VERSION_2_1
+	auto func = clGetKernelSubGroupInfo;
+#else
+	auto func = (clGetKernelSubGroupInfoKHR_fn)clGetExtensionFunctionAddressForPlatform(device.platformId, "clGetKernelSubGroupInfoKHR");
+	if(!func) return 0;
+#endif
+	throwOnCLError(func(
+		id,
+		device.id,
+		param,
+		localSizes.size() * sizeof(size_t),
+		localSizes.data(),
+		sizeof(size_t),
+		&value,
+		nullptr
+	));
+	return value;
+}
+std::tuple<uint, uint> Kernel::getSquareWorkGroupSize2D() const {
+	/// The sub-group (warp/wavefront) size if known
+	uint n = (uint)getLocalSizeMultiple();
 
 	// perfect square
 	uint sq = (uint)sqrt((float)n);
@@ -94,7 +182,7 @@ std::tuple<uint, uint> Kernel::getSquareWorkGroupSize2D() const {
 		start++;
 		end--;
 	}
-	return std::make_tuple(x,y);
+	return std::make_tuple(std::max(x,y), std::min(x,y));
 }
 
 } /// opencl
\ No newline at end of file
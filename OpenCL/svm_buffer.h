@@ -0,0 +1,98 @@
+#pragma once
+
+namespace opencl {
+
+/// Shared virtual memory allocated with clSVMAlloc. The same pointer is
+/// valid on the host and in kernels so pointer based data structures can
+/// be shared without serialising them.
+///
+/// Coarse grain buffers must be mapped (CommandQueue::enqueueSvmMap) before
+/// the host touches them and unmapped before kernels use them. Fine grain
+/// buffers can be used by the host and device without mapping.
+///
+/// The memory is freed immediately when the SvmBuffer is destroyed, so
+/// finish every queue using it first. Freeing SVM that an enqueued
+/// kernel may still access is undefined behaviour.
+/// Create using Context::createSvmBuffer.
+class SvmBuffer final {
+public:
+	cl_context context;
+	void* ptr;
+	size_t size;
+	cl_svm_mem_flags flags;
+
+	SvmBuffer(cl_context context, void* ptr, size_t size, cl_svm_mem_flags flags)
+		: context(context), ptr(ptr), size(size), flags(flags) {}
+	SvmBuffer(const SvmBuffer&) = delete;
+	SvmBuffer& operator=(const SvmBuffer&) = delete;
+	SvmBuffer(SvmBuffer&& other) noexcept
+		: context(other.context), ptr(std::exchange(other.ptr, nullptr)), size(other.size), flags(other.flags) {}
+	SvmBuffer& operator=(SvmBuffer&& other) noexcept {
+		if(this != &other) {
+			if(ptr) clSVMFree(context, ptr);
+			context = other.context;
+			ptr     = std::exchange(other.ptr, nullptr);
+			size    = other.size;
+			flags   = other.flags;
+		}
+		return *this;
+	}
+	/// The caller must have finished all commands using the memory
+	~SvmBuffer() {
+		if(ptr) clSVMFree(context, ptr);
+	}
+	bool isFineGrain() const {
+		return (flags & CL_MEM_SVM_FINE_GRAIN_BUFFER) != 0;
+	}
+	template<typename T>
+	T* data() const {
+		return (T*)ptr;
+	}
+};
+
+/// Allocator for standard containers which allocates SVM, so that container
+/// storage can be passed straight to kernels, eg. kernel.setArgs(vec).
+/// Create using Context::createSvmAllocator.
+///
+/// Containers write to their storage as soon as elements are created. With
+/// fine grain SVM (the default) this needs no mapping. With coarse grain SVM
+/// reserve the capacity first and create elements inside an SvmMapScope.
+///
+/// Storage is freed immediately when the container reallocates or is
+/// destroyed, so finish every queue using it before growing the container
+/// past its capacity, shrinking it or destroying it.
+template<typename T>
+class SvmAllocator {
+public:
+	using value_type = T;
+
+	cl_context context;
+	cl_svm_mem_flags flags;
+
+	SvmAllocator(cl_context context, cl_svm_mem_flags flags) : context(context), flags(flags) {}
+	template<typename U>
+	SvmAllocator(const SvmAllocator<U>& other) : context(other.context), flags(other.flags) {}
+
+	T* allocate(size_t n) {
+		void* ptr = clSVMAlloc(context, flags, n * sizeof(T), (uint)std::max(alignof(T), (size_t)16));
+		if(!ptr) throw std::bad_alloc();
+		return (T*)ptr;
+	}
+	/// The caller must have finished all commands using the storage
+	void deallocate(T* ptr, size_t) {
+		clSVMFree(context, ptr);
+	}
+	template<typename U>
+	bool operator==(const SvmAllocator<U>& other) const {
+		return context == other.context && flags == other.flags;
+	}
+	template<typename U>
+	bool operator!=(const SvmAllocator<U>& other) const {
+		return !(*this == other);
+	}
+};
+
+template<typename T>
+using SvmVector = std::vector<T, SvmAllocator<T>>;
+
+} /// opencl
@@ -0,0 +1,120 @@
+#pragma once
+
+namespace opencl {
+
+/// A local size and the global size padded to a multiple of it
+struct TilePlan final {
+	NDRange local;
+	NDRange global;
+	/// Useful work-items / launched work-item slots (including idle sub-group lanes)
+	double efficiency = 0;
+	/// True if each row of a work-group covers at least one 128 byte memory transaction
+	bool coalesced = false;
+
+	string toString() const {
+		CharBuffer buf;
+		buf.append("TilePlan {local:");
+		for(uint d = 0; d<local.dims; d++) buf.appendFmt(" %llu", local[d]);
+		buf.append(", global:");
+		for(uint d = 0; d<global.dims; d++) buf.appendFmt(" %llu", global[d]);
+		buf.appendFmt(", efficiency: %.1f%%, coalesced: %s}", efficiency * 100, coalesced ? "yes" : "no");
+		return buf.std_str();
+	}
+};
+
+/// Chooses a 1D, 2D or 3D local size for a launch shape.
+///
+/// Candidates respect the kernel and device work-group size limits,
+/// maxWorkItemSizes and the local memory left after the kernel's own
+/// use. They are ranked by:
+///   1. rows (dimension 0) at least 128 bytes wide, or the whole row,
+///      so global memory accesses coalesce
+///   2. the fewest wasted work-items after padding the global size and
+///      rounding the group up to whole sub-groups
+///   3. the largest work-group
+///   4. the widest rows
+///
+/// Kernels declaring reqd_work_group_size always get the required size.
+///
+/// Launch with enqueuePadded when plan.global differs from the true size.
+///
+/// Usage:
+///		auto plan = TilePlanner::plan(kernel, NDRange{width, height}, sizeof(float));
+///		queue.enqueuePadded(kernel, NDRange{width, height}, plan.local, sizeArgIndex);
+class TilePlanner {
+	static const ulong TRANSACTION_BYTES = 128;
+public:
+	/// elementSize is the size of the elements read along dimension 0.
+	/// localMemPerItem is the dynamic local memory needed per work-item.
+	static TilePlan plan(const Kernel& kernel, const NDRange& global, ulong elementSize = 4, ulong localMemPerItem = 0) {
+		assert(global.dims >= 1 && global.dims <= 3);
+		auto& device   = kernel.program.device;
+		ulong multiple = kernel.getLocalSizeMultiple();
+		ulong rowBytes = std::min(TRANSACTION_BYTES, global[0] * elementSize);
+
+		auto required = kernel.getCompileWorkGroupSize();
+		if(required[0] != 0) {
+			TilePlan result;
+			result.local      = global.dims == 1 ? NDRange{required[0]} : global.dims == 2 ? NDRange{required[0], required[1]} : NDRange{required[0], required[1], required[2]};
+			result.global     = NDRange::roundUp(global, result.local);
+			result.coalesced  = required[0] * elementSize >= rowBytes;
+			result.efficiency = efficiency(global, result.global, required[0] * required[1] * required[2], multiple);
+			return result;
+		}
+
+		ulong maxSize  = std::min(kernel.getMaxWorkGroupSize(), device.maxWorkGroupSize);
+		if(localMemPerItem > 0) {
+			ulong available = device.localMemSize - std::min(device.localMemSize, kernel.getLocalMemSize());
+			maxSize = std::min(maxSize, available / localMemPerItem);
+		}
+		if(maxSize == 0) throw std::runtime_error("TilePlanner: not enough local memory for one work-item");
+
+		auto maxItem = [&](uint d) {
+			ulong limit = d < global.dims ? global[d] : 1;
+			if(d < device.maxWorkItemSizes.size()) limit = std::min(limit, device.maxWorkItemSizes[d]);
+			return std::max<ulong>(1, std::min(limit, maxSize));
+		};
+
+		TilePlan best;
+		ulong bestTotal = 0;
+		for(ulong x = 1; x <= maxItem(0); x++) {
+			for(ulong y = 1; y <= maxItem(1) && x*y <= maxSize; y++) {
+				for(ulong z = 1; z <= maxItem(2) && x*y*z <= maxSize; z++) {
+					NDRange local = global.dims == 1 ? NDRange{x} : global.dims == 2 ? NDRange{x, y} : NDRange{x, y, z};
+					ulong total = x * y * z;
+
+					TilePlan candidate;
+					candidate.local      = local;
+					candidate.global     = NDRange::roundUp(global, local);
+					candidate.coalesced  = x * elementSize >= rowBytes;
+					candidate.efficiency = efficiency(global, candidate.global, total, multiple);
+
+					if(isBetter(candidate, total, best, bestTotal)) {
+						best      = candidate;
+						bestTotal = total;
+					}
+				}
+			}
+		}
+		return best;
+	}
+private:
+	static double efficiency(const NDRange& global, const NDRange& padded, ulong groupSize, ulong multiple) {
+		double useful = 1, launched = 1;
+		for(uint d = 0; d<global.dims; d++) {
+			useful   *= (double)global[d];
+			launched *= (double)padded[d];
+		}
+		double lanes = (double)groupSize / (((groupSize + multiple - 1) / multiple) * multiple);
+		return (useful / launched) * lanes;
+	}
+	static bool isBetter(const TilePlan& a, ulong aTotal, const TilePlan& b, ulong bTotal) {
+		if(bTotal == 0) return true;
+		if(a.coalesced != b.coalesced) return a.coalesced;
+		if(std::abs(a.efficiency - b.efficiency) > 1e-9) return a.efficiency > b.efficiency;
+		if(aTotal != bTotal) return aTotal > bTotal;
+		return a.local[0] > b.local[0];
+	}
+};
+
+} /// opencl
@@ -0,0 +1,114 @@
+#pragma once
+
+namespace opencl {
+
+/// A pointer and an element count. Stands in for std::span, which is not
+/// available before C++20. Converts implicitly from std::vector (with any
+/// allocator) and from Span<T> to Span<const T>. Wrap arrays and other
+/// pointers with Span{ptr, count}.
+template<typename T>
+class Span final {
+	T* ptr = nullptr;
+	size_t count = 0;
+public:
+	using value_type = std::remove_const_t<T>;
+
+	Span() {}
+	Span(T* ptr, size_t count) : ptr(ptr), count(count) {}
+	template<typename A>
+	Span(std::vector<value_type, A>& v) : ptr(v.data()), count(v.size()) {}
+	template<typename A, typename U = T, typename = std::enable_if_t<std::is_const<U>::value>>
+	Span(const std::vector<value_type, A>& v) : ptr(v.data()), count(v.size()) {}
+	template<typename U, typename = std::enable_if_t<std::is_same<const U, T>::value>>
+	Span(const Span<U>& other) : ptr(other.data()), count(other.size()) {}
+
+	T* data() const { return ptr; }
+	size_t size() const { return count; }
+	size_t sizeBytes() const { return count * sizeof(T); }
+	bool empty() const { return count == 0; }
+	T* begin() const { return ptr; }
+	T* end() const { return ptr + count; }
+	T& operator[](size_t i) const { assert(i < count); return ptr[i]; }
+
+	Span subspan(size_t offset, size_t n) const {
+		assert(offset + n <= count);
+		return Span{ptr + offset, n};
+	}
+};
+
+/// A Buffer of count elements of T. The typed CommandQueue read, write,
+/// map and copy overloads take Span<T> and check element counts, and do
+/// not compile if the element types differ.
+/// Create using Context::createTypedBuffer.
+///
+/// Usage:
+///		auto buf = context.createTypedBuffer<float>(N, CL_MEM_READ_WRITE);
+///		queue.enqueueWriteBuffer(buf, hostVector);
+///		auto program = context.createProgram(L"scale.cl", {String::format("-D VEC=%u", buf.getVectorWidth())});
+template<typename T>
+class TypedBuffer final : public Buffer {
+	static_assert(std::is_trivially_copyable<T>::value, "Buffer elements must be trivially copyable");
+public:
+	using value_type = T;
+
+	TypedBuffer(cl_mem id, cl_mem_flags flags, size_t count) : Buffer(id, flags, count * sizeof(T)) {}
+	TypedBuffer(cl_mem id, cl_mem_flags flags, size_t count, cl_mem parent, size_t offsetBytes)
+		: Buffer(id, flags, count * sizeof(T), parent, offsetBytes) {}
+
+	size_t count() const {
+		return size / sizeof(T);
+	}
+	/// A view of count elements starting at element offset. See Buffer::createSubBuffer.
+	TypedBuffer createSubBuffer(size_t offset, size_t count, cl_mem_flags flags = 0) const {
+		cl_mem_flags subFlags;
+		cl_mem subId = createRegion(offset * sizeof(T), count * sizeof(T), flags, subFlags);
+		return TypedBuffer{subId, subFlags, count, id, offset * sizeof(T)};
+	}
+	/// The widest vector of T (1, 2, 4, 8 or 16 elements, up to maxWidth) which
+	/// divides the element count and is aligned at the start of this buffer, so
+	/// a kernel can use vloadN/vstoreN over the whole buffer without a scalar tail
+	uint getVectorWidth(uint maxWidth = 16) const {
+		uint width = 1;
+		while(width * 2 <= maxWidth && count() % (width * 2) == 0 && offset % (sizeof(T) * width * 2) == 0) {
+			width *= 2;
+		}
+		return width;
+	}
+};
+
+/// The default image format for pixels of type T. Integer types map to
+/// unnormalised channels (read_imageui / read_imagei). Pass a format
+/// explicitly for normalised channels, eg. {CL_RGBA, CL_UNORM_INT8}.
+template<typename T>
+struct ImageFormat {
+	static_assert(sizeof(T) == 0, "No default cl_image_format for this pixel type. Pass one explicitly");
+};
+template<> struct ImageFormat<cl_uchar>  { static cl_image_format value() { return {CL_R, CL_UNSIGNED_INT8}; } };
+template<> struct ImageFormat<cl_uchar4> { static cl_image_format value() { return {CL_RGBA, CL_UNSIGNED_INT8}; } };
+template<> struct ImageFormat<cl_ushort> { static cl_image_format value() { return {CL_R, CL_UNSIGNED_INT16}; } };
+template<> struct ImageFormat<cl_uint>   { static cl_image_format value() { return {CL_R, CL_UNSIGNED_INT32}; } };
+template<> struct ImageFormat<cl_uint4>  { static cl_image_format value() { return {CL_RGBA, CL_UNSIGNED_INT32}; } };
+template<> struct ImageFormat<cl_int>    { static cl_image_format value() { return {CL_R, CL_SIGNED_INT32}; } };
+template<> struct ImageFormat<cl_float>  { static cl_image_format value() { return {CL_R, CL_FLOAT}; } };
+template<> struct ImageFormat<cl_float2> { static cl_image_format value() { return {CL_RG, CL_FLOAT}; } };
+template<> struct ImageFormat<cl_float4> { static cl_image_format value() { return {CL_RGBA, CL_FLOAT}; } };
+
+/// A 2D Image with pixels of type T. sizeof(T) is checked against the
+/// format's element size when it is created.
+/// Create using Context::createTypedImage2D.
+template<typename T>
+class TypedImage final : public Image {
+	static_assert(std::is_trivially_copyable<T>::value, "Image pixels must be trivially copyable");
+public:
+	using value_type = T;
+	cl_image_format format;
+
+	TypedImage(cl_mem id, cl_mem_flags flags, ulong width, ulong height, cl_image_format format)
+		: Image(id, flags, width, height), format(format) {}
+
+	ulong count() const {
+		return width * height;
+	}
+};
+
+} /// opencl
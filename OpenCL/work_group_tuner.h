@@ -0,0 +1,255 @@
+#pragma once
+
+namespace opencl {
+
+/// Finds the fastest local work-group size for a kernel and global size.
+/// Candidates are multiples of the sub-group size (or preferred multiple) up
+/// to the kernel maximum which divide the global size. Kernels declaring
+/// reqd_work_group_size only have one candidate. Each candidate is timed
+/// using profiling events and the winner is persisted in a database file
+/// keyed by program, build (source, options and libraries), kernel, device,
+/// driver and global size bucket (each dimension rounded up to a power of 2).
+///
+/// Only tune kernels that can safely be run more than once with the
+/// same arguments.
+///
+/// Usage:
+///		WorkGroupTuner tuner{L"workgroups.db"};
+///		tuner.tune(queue, kernel, {N});
+///		queue.setWorkGroupTuner(&tuner);
+///		queue.enqueueKernel(kernel, {N});	// uses the tuned local size
+class WorkGroupTuner {
+public:
+	struct Result final {
+		vector<ulong> localSizes;
+		double millis = 0;
+	};
+private:
+	/// Tuned mode lookups by kernel instance and size bucket
+	struct LaunchKey final {
+		const Kernel* kernel;
+		ulong buckets[3];
+		bool operator<(const LaunchKey& o) const {
+			if(kernel != o.kernel) return kernel < o.kernel;
+			return std::lexicographical_compare(buckets, buckets + 3, o.buckets, o.buckets + 3);
+		}
+	};
+	/// Checked on each hit in case the Kernel was released and another created at the same address
+	struct LaunchEntry final {
+		ulong buildHash;
+		string kernelName;
+		const Device* device;
+		NDRange local;
+	};
+	std::filesystem::path databaseFile;
+	mutable std::mutex lock;
+	std::map<string, vector<ulong>> database;
+	mutable std::map<LaunchKey, LaunchEntry> launchCache;
+	vector<Result> lastResults;
+	mutable uint hits   = 0;
+	mutable uint misses = 0;
+public:
+	WorkGroupTuner(const wstring& databaseFile) : databaseFile(databaseFile) {
+		readDatabase();
+	}
+	/// Returns the tuned local sizes or an empty vector (driver choice)
+	/// if the kernel has not been tuned for this size bucket or the tuned
+	/// sizes do not divide globalSizes.
+	vector<ulong> getLocalSizes(const Kernel& kernel, const vector<ulong>& globalSizes) const {
+		std::lock_guard<std::mutex> guard(lock);
+		auto it = database.find(keyOf(kernel, globalSizes));
+		if(it == database.end() || it->second.size() != globalSizes.size() || !divides(it->second, globalSizes)) {
+			misses++;
+			return {};
+		}
+		hits++;
+		return it->second;
+	}
+	/// Same as getLocalSizes but does not allocate after the first
+	/// lookup for each kernel and size bucket. Used by tuned mode.
+	NDRange getLocalSize(const Kernel& kernel, const NDRange& global) const {
+		std::lock_guard<std::mutex> guard(lock);
+		LaunchKey key{&kernel, {1, 1, 1}};
+		for(uint d = 0; d<global.dims; d++) {
+			key.buckets[d] = bucketOf(global[d]);
+		}
+		auto it = launchCache.find(key);
+		if(it == launchCache.end() || it->second.buildHash != kernel.program.buildHash ||
+		   it->second.device != &kernel.program.device || it->second.kernelName != kernel.name)
+		{
+			auto found = database.find(keyOf(kernel, vector<ulong>(global.sizes, global.sizes + global.dims)));
+			NDRange local;
+			if(found != database.end() && found->second.size() == global.dims) {
+				auto& s = found->second;
+				local = s.size() == 1 ? NDRange{s[0]} : s.size() == 2 ? NDRange{s[0], s[1]} : NDRange{s[0], s[1], s[2]};
+			}
+			it = launchCache.insert_or_assign(key, LaunchEntry{kernel.program.buildHash, kernel.name, &kernel.program.device, local}).first;
+		}
+		auto& local = it->second.local;
+		bool valid = local.dims != 0;
+		for(uint d = 0; d<local.dims; d++) {
+			if(local[d] == 0 || global[d] % local[d] != 0) valid = false;
+		}
+		if(!valid) {
+			misses++;
+			return {};
+		}
+		hits++;
+		return local;
+	}
+	/// Valid local sizes for the kernel and global size
+	static vector<vector<ulong>> candidates(const Kernel& kernel, const vector<ulong>& globalSizes) {
+		assert(globalSizes.size() >= 1 && globalSizes.size() <= 3);
+		auto dims = globalSizes.size();
+
+		auto required = kernel.getCompileWorkGroupSize();
+		if(required[0] != 0) {
+			return {vector<ulong>(required.begin(), required.begin() + dims)};
+		}
+
+		auto& device    = kernel.program.device;
+		ulong maxSize   = std::min(kernel.getMaxWorkGroupSize(), device.maxWorkGroupSize);
+		ulong multiple  = kernel.getLocalSizeMultiple();
+		auto maxItem    = [&](ulong d) { return d < device.maxWorkItemSizes.size() ? device.maxWorkItemSizes[d] : maxSize; };
+
+		vector<vector<ulong>> result;
+		for(ulong total = multiple; total <= maxSize; total *= 2) {
+			if(dims == 1) {
+				vector<ulong> local = {total};
+				if(total <= maxItem(0) && divides(local, globalSizes)) result.push_back(local);
+				continue;
+			}
+			/// Split total into x * y, leaving z as 1
+			for(ulong x = 1; x <= total; x++) {
+				if(total % x != 0) continue;
+				vector<ulong> local = {x, total / x};
+				if(dims == 3) local.push_back(1);
+
+				bool valid = true;
+				for(ulong d = 0; d<dims; d++) {
+					if(local[d] > maxItem(d)) valid = false;
+				}
+				if(valid && divides(local, globalSizes)) result.push_back(local);
+			}
+		}
+		return result;
+	}
+	/// Time each candidate on queue, which must have profiling enabled,
+	/// and store the fastest. The kernel arguments must already be set.
+	/// Returns the winning local sizes or an empty vector if there are no candidates.
+	vector<ulong> tune(CommandQueue& queue, const Kernel& kernel, const vector<ulong>& globalSizes, uint iterations = 5) {
+		cl_command_queue_properties properties = 0;
+		throwOnCLError(clGetCommandQueueInfo(queue.id, CL_QUEUE_PROPERTIES, sizeof(properties), &properties, nullptr));
+		if((properties & CL_QUEUE_PROFILING_ENABLE) == 0) {
+			throw std::runtime_error("WorkGroupTuner requires a queue with profiling enabled");
+		}
+
+		vector<Result> results;
+		for(auto& local : candidates(kernel, globalSizes)) {
+			Result result;
+			result.localSizes = local;
+			try{
+				/// Warm up
+				queue.enqueueKernel(kernel, globalSizes, local);
+				queue.finish();
+
+				ulong nanos = 0;
+				for(uint i = 0; i<iterations; i++) {
+					Event event;
+					queue.enqueueKernel(kernel, globalSizes, local, {{}, &event});
+					queue.finish();
+					nanos += event.getRunTime();
+				}
+				result.millis = (nanos * 1e-6) / std::max(1u, iterations);
+				results.push_back(result);
+			}catch(std::exception& e) {
+				/// eg. CL_OUT_OF_RESOURCES if the kernel uses too many registers
+				printf("Local size candidate failed: %s\n", e.what());
+			}
+		}
+
+		const Result* best = nullptr;
+		for(auto& r : results) {
+			if(!best || r.millis < best->millis) best = &r;
+		}
+
+		std::lock_guard<std::mutex> guard(lock);
+		lastResults = results;
+		if(!best) return {};
+
+		database[keyOf(kernel, globalSizes)] = best->localSizes;
+		launchCache.clear();
+		writeDatabase();
+		return best->localSizes;
+	}
+	/// Results of all candidates from the last call to tune
+	vector<Result> getLastResults() const {
+		std::lock_guard<std::mutex> guard(lock);
+		return lastResults;
+	}
+	string toString() const {
+		std::lock_guard<std::mutex> guard(lock);
+		CharBuffer buf;
+		buf.appendFmt("WorkGroupTuner {entries: %u, hits: %u, misses: %u\n", (uint)database.size(), hits, misses);
+		for(auto& r : lastResults) {
+			buf.appendFmt("  %8.3f ms :", r.millis);
+			for(auto size : r.localSizes) {
+				buf.appendFmt(" %llu", size);
+			}
+			buf.append("\n");
+		}
+		buf.append("}");
+		return buf.std_str();
+	}
+private:
+	static bool divides(const vector<ulong>& localSizes, const vector<ulong>& globalSizes) {
+		for(ulong d = 0; d<globalSizes.size(); d++) {
+			if(localSizes[d] == 0 || globalSizes[d] % localSizes[d] != 0) return false;
+		}
+		return true;
+	}
+	static ulong bucketOf(ulong size) {
+		ulong bucket = 1;
+		while(bucket < size) bucket *= 2;
+		return bucket;
+	}
+	static string keyOf(const Kernel& kernel, const vector<ulong>& globalSizes) {
+		auto& device = kernel.program.device;
+		string key = WString::toString(kernel.program.filename) + String::format("|%016llx|", kernel.program.buildHash) + 
+					 kernel.name + "|" + device.name + "|" + device.driverVersion + "|";
+		for(ulong d = 0; d<globalSizes.size(); d++) {
+			if(d > 0) key += "x";
+			key += String::format("%llu", bucketOf(globalSizes[d]));
+		}
+		return key;
+	}
+	/// One entry per line: key<TAB>size<TAB>size...
+	void readDatabase() {
+		std::ifstream in(databaseFile);
+		string line;
+		while(std::getline(in, line)) {
+			auto tab = line.find('\t');
+			if(tab == string::npos) continue;
+
+			vector<ulong> sizes;
+			std::istringstream values(line.substr(tab + 1));
+			ulong size;
+			while(values >> size) sizes.push_back(size);
+			if(sizes.empty() || sizes.size() > 3) continue;
+
+			database[line.substr(0, tab)] = sizes;
+		}
+	}
+	void writeDatabase() const {
+		std::ofstream out(databaseFile, std::ios::trunc);
+		for(auto& it : database) {
+			out << it.first;
+			for(auto size : it.second) {
+				out << "\t" << size;
+			}
+			out << "\n";
+		}
+	}
+};
+
+} /// opencl
@@ -3,9 +3,11 @@
 kernel void Add(global const uint* a, 
 				global const uint* b, 
 				global uint* c,
-				const uint delta)
+				const uint delta,
+				const ulong n)
 {
-    int tid = get_global_id(0);
+    size_t tid = get_global_id(0);
+    if(tid >= n) return;
    
     c[tid] = a[tid] + b[tid] + delta;
 }
\ No newline at end of file
@@ -0,0 +1,6 @@
+/// Does no work. Used to measure the host cost of launching a kernel.
+kernel void Empty(global uint* out,
+                  const uint value)
+{
+    if(get_global_id(0) == 0 && value == 0xffffffff) out[0] = value;
+}
@@ -0,0 +1,5 @@
+/// Device functions compiled once by Context::getLibrary
+/// and linked into any program that declares them.
+uint addWithDelta(uint a, uint b, uint delta) {
+    return a + b + delta;
+}
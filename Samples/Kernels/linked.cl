@@ -0,0 +1,14 @@
+/// Defined in library.cl
+uint addWithDelta(uint a, uint b, uint delta);
+
+kernel void AddLinked(global const uint* a,
+                      global const uint* b,
+                      global uint* c,
+                      const uint delta,
+                      const ulong n)
+{
+    size_t tid = get_global_id(0);
+    if(tid >= n) return;
+
+    c[tid] = addWithDelta(a[tid], b[tid], delta);
+}
@@ -0,0 +1,50 @@
+/// Number of Collatz steps needed for x to reach 1.
+/// The work per item is very uneven.
+inline uint collatzSteps(ulong x) {
+    uint steps = 0;
+    while(x > 1) {
+        x = (x & 1) ? 3*x + 1 : x >> 1;
+        steps++;
+    }
+    return steps;
+}
+
+//================================================================
+// One work-item per value
+//================================================================
+kernel void Collatz(global uint* steps,
+                    const ulong n)
+{
+    size_t i = get_global_id(0);
+    if(i >= n) return;
+
+    steps[i] = collatzSteps(i + 1);
+}
+
+//================================================================
+// Persistent threads. Launched with PersistentLaunch, each 
+// work-group takes chunks of values from counter until all
+// n values are done.
+//================================================================
+kernel void CollatzPersistent(global uint* steps,
+                              global volatile uint* counter,
+                              const ulong n,
+                              const uint chunkSize)
+{
+    local uint chunk;
+
+    while(true) {
+        if(get_local_id(0) == 0) chunk = atomic_inc(counter);
+        barrier(CLK_LOCAL_MEM_FENCE);
+
+        const ulong start = (ulong)chunk * chunkSize;
+        const ulong end   = min(start + chunkSize, n);
+        barrier(CLK_LOCAL_MEM_FENCE);
+
+        if(start >= n) return;
+
+        for(ulong i = start + get_local_id(0); i < end; i += get_local_size(0)) {
+            steps[i] = collatzSteps(i + 1);
+        }
+    }
+}
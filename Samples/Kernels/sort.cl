@@ -78,11 +78,11 @@ kernel void merge(
     global float* out,
     const uint chunkSize)
 {
-    const int tid        = get_global_id(0);
-    const int chunkSize2 = chunkSize*2;
-    const int chunk      = tid/chunkSize2;
-    const bool onLeft    = tid%chunkSize2 < chunkSize;
-    const float v        = in[tid];
+    const size_t tid        = get_global_id(0);
+    const size_t chunkSize2 = (size_t)chunkSize*2;
+    const size_t chunk      = tid/chunkSize2;
+    const bool onLeft       = tid%chunkSize2 < chunkSize;
+    const float v           = in[tid];
 
     const global float* a   = in+chunkSize2*chunk;
     const global float* b   = a+chunkSize;
@@ -112,7 +112,7 @@ kernel void bitonicSortLocal(
     const int i = get_local_id(0); // index in workgroup
 
     /// Move to block start
-    const int offset = get_group_id(0) * WORK_GROUP_SIZE;
+    const size_t offset = get_group_id(0) * WORK_GROUP_SIZE;
     data  += offset;
 
     /// Cache the local block
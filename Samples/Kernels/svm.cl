@@ -0,0 +1,10 @@
+/// Scale values in place. data is SVM shared with the host.
+kernel void Scale(global float* data,
+                  const float factor,
+                  const ulong n)
+{
+    size_t i = get_global_id(0);
+    if(i >= n) return;
+
+    data[i] *= factor;
+}
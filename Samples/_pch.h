@@ -14,6 +14,7 @@
 
 #include <cstdio>
 #include <cassert>
+#include <cstring>
 #include <crtdbg.h>
 
 /// std headers
@@ -23,7 +24,22 @@
 #include <exception>
 #include <algorithm>
 #include <chrono>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <future>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <unordered_map>
+#include <map>
+#include <list>
+#include <functional>
+#include <iterator>
+#include <cmath>
 #include <tuple>
+#include <type_traits>
+#include <utility>
 #include <random>
 
 /// OpenCL
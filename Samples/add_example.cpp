@@ -27,6 +27,9 @@ void addExample() {
 		auto context  = platform.createContext(CL_DEVICE_TYPE_GPU);
 		auto queue    = context.createQueue(true);
 
+		/// Reuse the program binary built by a previous run if there is one
+		context.enableProgramCache(L"ProgramCache/");
+
 		/// Create some data
 		inputA = new uint[N];
 		inputB = new uint[N];
@@ -48,37 +51,62 @@ void addExample() {
 		uint delta = 50;
 
 		Kernel kernel = program.getKernel("Add");
-		kernel.setArg(0, inputBuffer1);
-		kernel.setArg(1, inputBuffer2);
-		kernel.setArg(2, outputBuffer);
-		kernel.setArg(3, sizeof(uint), (void*)&delta);
+		kernel.setArgs(inputBuffer1, inputBuffer2, outputBuffer, delta, (cl_ulong)N);
 
 		/// Write our input buffers to the device
 		queue.enqueueWriteBuffer(inputBuffer1, inputA);
 		queue.enqueueWriteBuffer(inputBuffer2, inputB);
 
+		/// Find the best local size on the first run and reuse it after that
+		WorkGroupTuner tuner{L"workgroups.db"};
+		if(tuner.getLocalSizes(kernel, {N}).empty()) {
+			tuner.tune(queue, kernel, {N});
+		}
+		queue.setWorkGroupTuner(&tuner);
+
 		/// Execute the kernel
 		Event kernelEvent;
 		queue.enqueueKernel(
 			kernel,
 			{N},					// global sizes
-			{},						// local sizes
+			{},						// local sizes (tuned)
 			{{}, &kernelEvent}		// events
 		);
 
 		/// Read back the data
 		queue.enqueueReadBuffer(outputBuffer, output, CL_TRUE);
 
+		/// Run again as 4 smaller launches, reading back each part of the output as it completes
+		uint launches = queue.enqueueChunked(kernel, {N}, {}, {N / 4}, 
+			[&](ulong offset, ulong count, const Event& event) {
+				queue.enqueueReadBuffer(outputBuffer, output + offset, offset * sizeof(uint), count * sizeof(uint), CL_FALSE, {{event.id}});
+			}
+		);
+
 		queue.finish();
 		auto end = std::chrono::high_resolution_clock::now();
 
 		auto kernelTime = kernelEvent.getRunTime();
 		kernelEvent.release();
 
+		/// Process N-1 values using the local size chosen by TilePlanner, which does not divide it.
+		/// The padding work-items are skipped by the bounds guard in the kernel.
+		TilePlan plan = TilePlanner::plan(kernel, {N - 1}, sizeof(uint));
+		queue.enqueuePadded(kernel, {N - 1}, plan.local, 4);
+
+		/// Read back only the second half of the output through a sub-buffer.
+		/// N/2 uints is a multiple of the sub-buffer alignment on current devices
+		Buffer secondHalf = outputBuffer.createSubBuffer(sizeof(uint) * N / 2, sizeof(uint) * N / 2);
+		queue.enqueueReadBuffer(secondHalf, output + N / 2, CL_TRUE);
+
 		printf("\n");
 		printf("Num kernel threads executed .. %u\n", N);
 		printf("Total time ................... %.3f ms\n", (end - start).count() * 1e-6);
-		printf("Kernel time .................. %.3f ms\n\n", kernelTime * 1e-6);
+		printf("Kernel time .................. %.3f ms\n", kernelTime * 1e-6);
+		printf("Chunked launches ............. %u\n", launches);
+		printf("%s\n", plan.toString().c_str());
+		printf("%s\n", context.getProgramCache()->toString().c_str());
+		printf("%s\n\n", tuner.toString().c_str());
 
 		/// Check the results
 		for(int i = 0; i < N; i++) {
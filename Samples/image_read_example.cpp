@@ -55,7 +55,8 @@ void imageReadExample() {
 			nullptr
 		);
 
-		auto program = context.createProgram(L"kernels/image_read.cl");
+		/// Compiled into the executable so there is no file I/O
+		auto program = context.createProgramFromEmbedded("image_read.cl");
 
 		auto kernel = program.getKernel("RandomImageRead");
 		kernel.setArg(0, image2d);
@@ -0,0 +1,93 @@
+#include "_pch.h"
+
+using namespace core;
+using std::string;
+using std::wstring;
+using std::vector;
+using std::shared_ptr;
+
+#include "../OpenCL/_exports.h"
+using namespace opencl;
+
+/// Measure the host time taken to enqueue many small kernels using
+/// setArgs + enqueueKernel, a KernelFunctor and a CommandRecording replay,
+/// and the cost of temporary buffers with and without the buffer pool.
+void launchOverheadExample() {
+	printf("==========================\n");
+	printf(" Running Launch Overhead\n");
+	printf("==========================\n\n");
+
+	const uint LAUNCHES = 1000;
+	const uint N        = 1024;
+	try{
+		OpenCL cl;
+		auto platform = cl.createPlatform(CL_DEVICE_TYPE_GPU);
+		auto context  = platform.createContext(CL_DEVICE_TYPE_GPU);
+		auto queue    = context.createQueue(false);
+
+		auto outBuf  = context.createDeviceBuffer(sizeof(uint) * N, CL_MEM_WRITE_ONLY);
+		auto program = context.createProgram(L"Kernels/empty.cl");
+
+		/// Returns the host enqueue time and the total time in milliseconds
+		auto measure = [&](const char* name, std::function<void()> enqueueAll) {
+			queue.finish();
+			auto start = std::chrono::high_resolution_clock::now();
+			enqueueAll();
+			auto enqueued = std::chrono::high_resolution_clock::now();
+			queue.finish();
+			auto end = std::chrono::high_resolution_clock::now();
+
+			printf("%-20s enqueue %7.2f us/launch, total %7.3f ms\n", name,
+				   (enqueued - start).count() * 1e-3 / LAUNCHES, (end - start).count() * 1e-6);
+		};
+
+		auto kernel = program.getKernel("Empty");
+		measure("enqueueKernel", [&]() {
+			for(uint i = 0; i<LAUNCHES; i++) {
+				kernel.setArgs(outBuf, i);
+				queue.enqueueKernel(kernel, {N});
+			}
+		});
+
+		auto empty = program.getKernelFunctor<Buffer, uint>("Empty", queue);
+		measure("KernelFunctor", [&]() {
+			for(uint i = 0; i<LAUNCHES; i++) {
+				empty(NDRange{N}, outBuf, i);
+			}
+		});
+
+		auto recordedKernel = program.getKernel("Empty");
+		CommandRecording recording;
+		for(uint i = 0; i<LAUNCHES; i++) {
+			recording.kernel(recordedKernel, NDRange{N}, NDRange{}, outBuf, i);
+		}
+		recording.validate();
+		measure("CommandRecording", [&]() {
+			recording.replay(queue);
+		});
+
+		/// Temporary buffers per launch. After the first launch the pool
+		/// serves every request without a driver allocation.
+		measure("createDeviceBuffer", [&]() {
+			for(uint i = 0; i<LAUNCHES; i++) {
+				auto temp = context.createDeviceBuffer(sizeof(uint) * N, CL_MEM_READ_WRITE);
+				kernel.setArgs(temp, i);
+				queue.enqueueKernel(kernel, {N});
+				queue.finish();
+			}
+		});
+		context.enableBufferPool();
+		measure("createPooledBuffer", [&]() {
+			for(uint i = 0; i<LAUNCHES; i++) {
+				auto temp = context.createPooledBuffer(sizeof(uint) * N, CL_MEM_READ_WRITE);
+				kernel.setArgs(*temp, i);
+				queue.enqueueKernel(kernel, {N});
+				queue.finish();
+			}
+		});
+		printf("%s\n\n", context.getBufferPool()->toString().c_str());
+
+	}catch(std::exception& e) {
+		printf("FAIL: %s\n", e.what());
+	}
+}
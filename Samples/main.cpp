@@ -9,16 +9,25 @@ using std::shared_ptr;
 #include "../OpenCL/_exports.h"
 using namespace opencl;
 
+/// Generated by Scripts/embed_kernels.ps1 as a pre-build step
+#include "Generated/embedded_kernels.h"
+
 void addExample();
 void enqueueExample();
 void imageReadExample();
+void launchOverheadExample();
+void persistentExample();
+void programExample();
 void sortExample();
+void svmExample();
 
 int wmain(int argc, const wchar_t* argv[]) {
 #ifdef _DEBUG
 	_CrtSetDbgFlag ( _CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF | _CRTDBG_CHECK_ALWAYS_DF);
 #endif
 
+	registerEmbeddedSources(embedded_kernels::SOURCES, _countof(embedded_kernels::SOURCES));
+
 	/// Display platform info
 	{
 		OpenCL cl;
@@ -31,7 +40,11 @@ int wmain(int argc, const wchar_t* argv[]) {
 	addExample();
 	enqueueExample();
 	imageReadExample();
+	persistentExample();
+	launchOverheadExample();
 	sortExample();
+	svmExample();
+	programExample();
 
 	printf("\n\nPress ENTER");
 	getchar();
@@ -0,0 +1,59 @@
+#include "_pch.h"
+
+using namespace core;
+using std::string;
+using std::wstring;
+using std::vector;
+using std::shared_ptr;
+
+#include "../OpenCL/_exports.h"
+using namespace opencl;
+
+/// Compare a plain NDRange launch with a persistent-threads
+/// launch on a workload where the work per item is uneven.
+void persistentExample() {
+	printf("==========================\n");
+	printf(" Running Persistent Kernel\n");
+	printf("==========================\n\n");
+
+	const uint N = 16 * 1024 * 1024;
+	try{
+		OpenCL cl;
+		auto platform = cl.createPlatform(CL_DEVICE_TYPE_GPU);
+		auto context  = platform.createContext(CL_DEVICE_TYPE_GPU);
+		auto queue    = context.createQueue(true);
+
+		auto plainBuf      = context.createTypedBuffer<uint>(N, CL_MEM_WRITE_ONLY);
+		auto persistentBuf = context.createTypedBuffer<uint>(N, CL_MEM_WRITE_ONLY);
+
+		auto program = context.createProgram(L"Kernels/persistent.cl");
+
+		/// One work-item per value
+		auto plainKernel = program.getKernel("Collatz");
+		plainKernel.setArgs(plainBuf, (cl_ulong)N);
+
+		Event plainEvent;
+		queue.enqueueNDRange(plainKernel, NDRange{N}, NDRange{}, {{}, &plainEvent});
+
+		/// Just enough work-groups to fill the device
+		auto persistentKernel = program.getKernel("CollatzPersistent");
+		persistentKernel.setArg(0, persistentBuf);
+
+		PersistentLaunch persistent{context};
+		Event persistentEvent;
+		ulong numGroups = persistent.enqueue(queue, persistentKernel, N, 1, 0, 0, {{}, &persistentEvent});
+
+		vector<uint> plain(N), result(N);
+		queue.enqueueReadBuffer(plainBuf, plain, CL_FALSE);
+		queue.enqueueReadBuffer(persistentBuf, result, CL_FALSE);
+		queue.finish();
+
+		printf("Num values ................... %u\n", N);
+		printf("Plain kernel time ............ %.3f ms\n", plainEvent.getRunTime() * 1e-6);
+		printf("Persistent kernel time ....... %.3f ms (%llu work-groups)\n", persistentEvent.getRunTime() * 1e-6, numGroups);
+		printf("Results match ................ %s\n\n", plain == result ? "true" : "false");
+
+	}catch(std::exception& e) {
+		printf("FAIL: %s\n", e.what());
+	}
+}
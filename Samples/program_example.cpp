@@ -0,0 +1,93 @@
+#include "_pch.h"
+
+using namespace core;
+using std::string;
+using std::wstring;
+using std::vector;
+using std::shared_ptr;
+
+#include "../OpenCL/_exports.h"
+using namespace opencl;
+
+/// Build programs on worker threads before they are needed
+/// and share them between callers.
+void programExample() {
+	printf("==========================\n");
+	printf(" Running Program Example\n");
+	printf("==========================\n\n");
+	const uint N = 1024;
+	try{
+		OpenCL cl;
+		auto platform = cl.createPlatform(CL_DEVICE_TYPE_GPU);
+		auto context  = platform.createContext(CL_DEVICE_TYPE_GPU);
+		auto queue    = context.createQueue(false);
+
+		/// Start building everything in the manifest for this device type
+		context.prewarm(ProgramManifest::load(L"programs.manifest"));
+
+		/// Build one more program in the background while the prewarm runs
+		ProgramFuture emptyFuture = context.createProgramAsync(L"Kernels/empty.cl");
+
+		vector<uint> a(N), b(N), c(N);
+		for(uint i = 0; i < N; i++) {
+			a[i] = i;
+			b[i] = N - i;
+		}
+		auto bufferA = context.createTypedBuffer<uint>(N, CL_MEM_READ_ONLY);
+		auto bufferB = context.createTypedBuffer<uint>(N, CL_MEM_READ_ONLY);
+		auto bufferC = context.createTypedBuffer<uint>(N, CL_MEM_WRITE_ONLY);
+		queue.enqueueWriteBuffer(bufferA, a);
+		queue.enqueueWriteBuffer(bufferB, b);
+
+		/// Blocks until the prewarmed build has finished. Does not build again
+		shared_ptr<Program> addProgram = context.getProgram(L"Kernels/add.cl");
+
+		/// This thread's instance of the kernel. Later lookups on this thread return the same one
+		Kernel& add = addProgram->getCachedKernel("Add");
+		add.setArgs(bufferA, bufferB, bufferC, 0u, (cl_ulong)N);
+		queue.enqueueKernel(add, {N});
+		queue.enqueueReadBuffer(bufferC, c, CL_TRUE);
+
+		for(uint i = 0; i < N; i++) {
+			assert(c[i] == N);
+		}
+
+		/// Compile the device functions once and link them into a kernel program
+		shared_ptr<ProgramLibrary> library = context.getLibrary(L"Kernels/library.cl");
+		Program linked = context.createProgram(L"Kernels/linked.cl", {}, {library});
+
+		Kernel addLinked = linked.getKernel("AddLinked");
+		addLinked.setArgs(bufferA, bufferB, bufferC, 1u, (cl_ulong)N);
+		queue.enqueueKernel(addLinked, {N});
+		queue.enqueueReadBuffer(bufferC, c, CL_TRUE);
+
+		for(uint i = 0; i < N; i++) {
+			assert(c[i] == N + 1);
+		}
+
+		/// Find the fastest build options for Add on the first run and reuse them after that
+		BuildOptionTuner optionTuner{context, L"buildoptions.db"};
+		vector<string> addOptions = optionTuner.getOptions(L"Kernels/add.cl", "Add");
+		if(addOptions.empty()) {
+			BuildOptionTuner::Benchmark benchmark;
+			benchmark.run = [&](Kernel& kernel, CommandQueue& q, Event& event) {
+				kernel.setArgs(bufferA, bufferB, bufferC, 0u, (cl_ulong)N);
+				q.enqueueKernel(kernel, {N}, {}, {{}, &event});
+			};
+			benchmark.readOutput = [&](CommandQueue& q) {
+				q.enqueueReadBuffer(bufferC, c, CL_TRUE);
+				return vector<float>(c.begin(), c.end());
+			};
+			addOptions = optionTuner.tune(L"Kernels/add.cl", "Add", {}, benchmark);
+			printf("%s\n", optionTuner.toString().c_str());
+		}
+		Program tunedAdd = context.createProgram(L"Kernels/add.cl", addOptions);
+		printf("Tuned Add built in %.3f ms\n", tunedAdd.buildMillis);
+
+		printf("%s\n", context.awaitPrewarm().c_str());
+		printf("empty.cl built in %.3f ms\n\n", emptyFuture.get().buildMillis);
+
+	} catch(std::exception& e) {
+		printf("FAIL: %s\n", e.what());
+	}
+}
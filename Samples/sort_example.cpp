@@ -57,25 +57,24 @@ void sortExample() {
 		/// The data set needs to be a multiple of the work group size
 		assert(N%WORK_GROUP_SIZE==0);
 
-		auto program = context.createProgram(L"Kernels/sort.cl",
-			{
-				String::format("-D WORK_GROUP_SIZE=%u", WORK_GROUP_SIZE).c_str(),
-				String::format("-D ASCENDING=%s", ascending ? "true":"false").c_str()
-			}
-		);
-
-		auto sortKernel = program.getKernel("bitonicSortLocal");
+		/// Each combination of defines is only built once
+		auto sortVariants = context.createProgramVariants(L"Kernels/sort.cl");
+		auto program = sortVariants.get({
+			{"WORK_GROUP_SIZE", String::format("%u", WORK_GROUP_SIZE)},
+			{"ASCENDING", ascending ? "true":"false"}
+		});
+
+		auto sortKernel = program->getKernel("bitonicSortLocal");
 		sortKernel.setArg(0, inBuf);
 
-		auto mergeKernel = program.getKernel("merge");
-		mergeKernel.setArg(0, inBuf);
-		mergeKernel.setArg(1, outBuf);
+		auto mergeKernel = program->getKernel("merge");
 
 		printf("\n");
 		printf("maxWorkGroupSize ................ %llu\n", sortKernel.getMaxWorkGroupSize());
 		printf("localMemSize .................... %llu\n", sortKernel.getLocalMemSize());
 		printf("privateMemSize .................. %llu\n", sortKernel.getPrivateMemSize());
 		printf("preferredWorkGroupSizeMultiple .. %llu\n", sortKernel.getPreferredWorkGroupSizeMultiple());
+		printf("\n%s\n", Occupancy::report(*program).c_str());
 
 		/// Run the sortKernel
 		printf("\nSorting %u local chunks of %u values\n", N/WORK_GROUP_SIZE, WORK_GROUP_SIZE);
@@ -101,18 +100,20 @@ void sortExample() {
 		/// one 16-value sorted chunk and we are finished:
 		///   0,1,2,2,2,3,3,4,5,5,7,8,8,9,10,10
 
-		/// Run the merge kernel iteratively
+		/// Record the merge passes once. The recording can be replayed
+		/// to sort more data of the same size with no setup cost.
+		CommandRecording mergePasses;
 		uint chunkSize = WORK_GROUP_SIZE;
 		while(chunkSize < N) {
 			printf("Merging %u-value chunks -> %u value chunks\n", chunkSize, chunkSize*2);
-			mergeKernel.setArg(2, chunkSize);
-			queue.enqueueKernel(mergeKernel, {N});
+			mergePasses.kernel(mergeKernel, NDRange{N}, NDRange{}, inBuf, outBuf, chunkSize);
 
 			/// Copy the out buf back to in buf ready for the next round
-			queue.enqueueCopyBuffer(outBuf, inBuf);
+			mergePasses.copy(outBuf, inBuf);
 
 			chunkSize <<= 1;
 		}
+		mergePasses.replay(queue);
 		/// Map the inBuf and write the random data
 		void* ptr2 = queue.enqueueMapBuffer(inBuf, 0, inBuf.size, CL_MAP_WRITE, CL_FALSE);
 		queue.enqueueUnmapMemObject(inBuf, ptr2);
@@ -125,7 +126,8 @@ void sortExample() {
 		printf("\n");
 		printf("Num kernel threads executed .. %u\n", N);
 		printf("Total time ................... %.3f ms\n", (end - start).count() * 1e-6);
-		printf("Sort kernel time ............. %.3f ms\n\n", sortKernelTime * 1e-6);
+		printf("Sort kernel time ............. %.3f ms\n", sortKernelTime * 1e-6);
+		printf("%s\n\n", sortVariants.toString().c_str());
 
 		/// Check that the results are sorted
 		vector<float> values;
@@ -0,0 +1,67 @@
+#include "_pch.h"
+
+using namespace core;
+using std::string;
+using std::wstring;
+using std::vector;
+using std::shared_ptr;
+
+#include "../OpenCL/_exports.h"
+using namespace opencl;
+
+/// Host and kernel share a std::vector allocated from SVM. 
+/// There are no write or read buffer copies.
+void svmExample() {
+	printf("==========================\n");
+	printf(" Running SVM Kernel\n");
+	printf("==========================\n\n");
+
+	const uint N = 1024 * 1024;
+	try{
+		auto start = std::chrono::high_resolution_clock::now();
+
+		OpenCL cl;
+		auto platform = cl.createPlatform(CL_DEVICE_TYPE_GPU);
+		auto context  = platform.createContext(CL_DEVICE_TYPE_GPU);
+		auto queue    = context.createQueue(true);
+
+		/// Fine grain SVM can be used by the host without mapping
+		bool fineGrain = context.device.supportsSvm(CL_DEVICE_SVM_FINE_GRAIN_BUFFER);
+		auto flags     = CL_MEM_READ_WRITE | (fineGrain ? CL_MEM_SVM_FINE_GRAIN_BUFFER : 0);
+
+		SvmVector<float> data(context.createSvmAllocator<float>(flags));
+		data.reserve(N);
+		{
+			/// Write the input directly into memory the kernel reads
+			SvmMapScope map(queue, data, CL_MAP_WRITE);
+			for(uint i = 0; i < N; i++) {
+				data.push_back((float)i);
+			}
+		}
+
+		auto program = context.createProgram(L"Kernels/svm.cl");
+		auto kernel  = program.getKernel("Scale");
+		kernel.setArgs(data, 2.0f, (cl_ulong)N);
+
+		Event kernelEvent;
+		queue.enqueueKernel(kernel, {N}, {}, {{}, &kernelEvent});
+		queue.finish();
+
+		bool correct = true;
+		{
+			SvmMapScope map(queue, data, CL_MAP_READ);
+			for(uint i = 0; i < N; i++) {
+				if(data[i] != i * 2.0f) correct = false;
+			}
+		}
+		auto end = std::chrono::high_resolution_clock::now();
+
+		printf("SVM ......................... %s grain\n", fineGrain ? "fine" : "coarse");
+		printf("Total time .................. %.3f ms\n", (end - start).count() * 1e-6);
+		printf("Kernel time ................. %.3f ms\n", kernelEvent.getRunTime() * 1e-6);
+		printf("Results correct ............. %s\n\n", correct ? "true" : "false");
+
+	}catch(std::exception& e) {
+		printf("FAIL: %s\n", e.what());
+	}
+}
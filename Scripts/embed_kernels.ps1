@@ -0,0 +1,64 @@
+# Generates a C++ header embedding every .cl file found in the given
+# directories as constexpr strings, plus an opencl::EmbeddedSource table
+# which can be passed to opencl::registerEmbeddedSources.
+#
+# Usage: embed_kernels.ps1 -Output <header.h> <kernelDir> [<kernelDir>...]
+#
+# The header is only rewritten if its content changes so that
+# unchanged kernels do not trigger a rebuild.
+param(
+    [Parameter(Mandatory=$true)][string]$Output,
+    [Parameter(Mandatory=$true, ValueFromRemainingArguments=$true)][string[]]$Directories
+)
+
+$ErrorActionPreference = "Stop"
+
+# MSVC limits a single string literal piece to 16KB
+$chunkSize = 8000
+$delimiter = "__CL__"
+
+$sb = New-Object System.Text.StringBuilder
+[void]$sb.AppendLine("/// Generated by Scripts/embed_kernels.ps1. Do not edit.")
+[void]$sb.AppendLine("#pragma once")
+[void]$sb.AppendLine("")
+[void]$sb.AppendLine("namespace embedded_kernels {")
+[void]$sb.AppendLine("")
+
+$entries = @()
+foreach($dir in $Directories) {
+    foreach($file in Get-ChildItem -Path $dir -Filter *.cl -File | Sort-Object Name) {
+        $text = [System.IO.File]::ReadAllText($file.FullName).Replace("`r`n", "`n")
+        if($text.Contains(")$delimiter`"")) {
+            throw "$($file.Name) contains the raw string delimiter"
+        }
+        $var = "src_" + ($file.Name -replace '[^A-Za-z0-9_]', '_')
+
+        [void]$sb.AppendLine("constexpr char $var[] =")
+        for($i = 0; $i -lt $text.Length; $i += $chunkSize) {
+            $piece = $text.Substring($i, [Math]::Min($chunkSize, $text.Length - $i))
+            [void]$sb.AppendLine("R`"$delimiter($piece)$delimiter`"")
+        }
+        if($text.Length -eq 0) {
+            [void]$sb.AppendLine("`"`"")
+        }
+        [void]$sb.AppendLine(";")
+        [void]$sb.AppendLine("")
+        $entries += "`t{`"$($file.Name)`", $var, sizeof($var) - 1, opencl::hashFNV1a($var, sizeof($var) - 1)},"
+    }
+}
+
+[void]$sb.AppendLine("constexpr opencl::EmbeddedSource SOURCES[] = {")
+foreach($e in $entries) {
+    [void]$sb.AppendLine($e)
+}
+[void]$sb.AppendLine("};")
+[void]$sb.AppendLine("")
+[void]$sb.AppendLine("} /// embedded_kernels")
+
+$content = $sb.ToString()
+$existing = if(Test-Path $Output) { [System.IO.File]::ReadAllText($Output) } else { "" }
+if($content -ne $existing) {
+    New-Item -ItemType Directory -Force -Path (Split-Path -Parent $Output) | Out-Null
+    [System.IO.File]::WriteAllText($Output, $content)
+    Write-Host "Embedded $($entries.Count) kernel sources in $Output"
+}